@@ -0,0 +1,323 @@
+#ifndef BENCH_HPP
+#define BENCH_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define BENCH_HAS_TSC 1
+#endif
+
+// Micro-benchmark harness shared by the examples:
+//
+//   bench::Result r = bench::run("sort", [&] { auto v = data; std::sort(v.begin(), v.end()); });
+//   std::cout << r << "\n";
+//
+// run() warms up, doubles the iteration count until one sample takes at least min_sample_time,
+// takes `samples` timed samples and reports statistics of the per-iteration time after rejecting
+// outliers outside the Tukey fences (1.5 IQR beyond the quartiles).
+namespace bench
+{
+    //////////////////////////////////////////////////////////////////////////////
+    // optimizer barriers
+
+#if defined(__GNUC__) || defined(__clang__)
+    // forces value to be computed (and kept in a register or memory) - the compiler cannot drop it as dead code
+    template <typename T>
+    inline void do_not_optimize(const T& value)
+    {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    template <typename T>
+    inline void do_not_optimize(T& value)
+    {
+        asm volatile("" : "+r,m"(value) : : "memory");
+    }
+
+    // all memory may have been read or written - pending stores cannot be sunk past this point
+    inline void clobber_memory()
+    {
+        asm volatile("" : : : "memory");
+    }
+#else
+    template <typename T>
+    inline void do_not_optimize(const T& value)
+    {
+        const volatile char* p = reinterpret_cast<const volatile char*>(&value);
+        (void)*p;
+        _ReadWriteBarrier();
+    }
+
+    inline void clobber_memory()
+    {
+        _ReadWriteBarrier();
+    }
+#endif
+
+    //////////////////////////////////////////////////////////////////////////////
+    // clocks
+
+    enum class Clock
+    {
+        steady, // std::chrono::steady_clock
+        tsc     // time stamp counter, calibrated against steady_clock - falls back to steady where unavailable
+    };
+
+    inline bool tsc_available()
+    {
+#ifdef BENCH_HAS_TSC
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    namespace detail
+    {
+        inline double steady_seconds()
+        {
+            return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+#ifdef BENCH_HAS_TSC
+        // measured once per process over ~20 ms
+        inline double tsc_seconds_per_tick()
+        {
+            static const double seconds_per_tick = [] {
+                const double start = steady_seconds();
+                const uint64_t ticks_start = __rdtsc();
+                while (steady_seconds() - start < 0.02)
+                {
+                }
+                const uint64_t ticks = __rdtsc() - ticks_start;
+                return (steady_seconds() - start) / static_cast<double>(ticks);
+            }();
+            return seconds_per_tick;
+        }
+#endif
+
+        inline double now(Clock clock)
+        {
+#ifdef BENCH_HAS_TSC
+            if (clock == Clock::tsc)
+                return static_cast<double>(__rdtsc()) * tsc_seconds_per_tick();
+#else
+            (void)clock;
+#endif
+            return steady_seconds();
+        }
+
+        template <typename F>
+        double time_iterations(F& f, uint64_t iterations, Clock clock)
+        {
+            clobber_memory();
+            const double start = now(clock);
+            for (uint64_t i = 0; i < iterations; ++i)
+                f();
+            clobber_memory();
+            return now(clock) - start;
+        }
+
+        // linear interpolation between closest ranks; sorted must not be empty
+        inline double percentile_of_sorted(const std::vector<double>& sorted, double q)
+        {
+            const double rank = std::clamp(q, 0.0, 1.0) * static_cast<double>(sorted.size() - 1);
+            const size_t lower = static_cast<size_t>(rank);
+            const size_t upper = std::min(lower + 1, sorted.size() - 1);
+            return sorted[lower] + (rank - static_cast<double>(lower)) * (sorted[upper] - sorted[lower]);
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    // running
+
+    struct Options
+    {
+        std::chrono::duration<double> warmup{0.05};
+        std::chrono::duration<double> min_sample_time{0.01};
+        size_t samples = 20;
+        uint64_t max_iterations = uint64_t{1} << 30; // per sample
+        Clock clock = Clock::steady;
+    };
+
+    struct Result
+    {
+        std::string name;
+        uint64_t iterations = 0;      // per sample
+        std::vector<double> samples;  // seconds per iteration, in measurement order
+        std::vector<double> accepted; // sorted samples inside the Tukey fences
+        size_t outliers = 0;
+
+        double mean = 0;
+        double stddev = 0;
+        double median = 0;
+        double min = 0;
+        double max = 0;
+
+        double percentile(double q) const
+        {
+            return accepted.empty() ? 0.0 : detail::percentile_of_sorted(accepted, q);
+        }
+    };
+
+    // statistics of per-iteration times (seconds); accessible on its own for externally measured samples
+    inline Result analyze(std::string name, std::vector<double> samples, uint64_t iterations = 1)
+    {
+        Result result{std::move(name), iterations, std::move(samples), {}, 0};
+        if (result.samples.empty())
+            return result;
+
+        std::vector<double> sorted = result.samples;
+        std::sort(sorted.begin(), sorted.end());
+
+        const double q1 = detail::percentile_of_sorted(sorted, 0.25);
+        const double q3 = detail::percentile_of_sorted(sorted, 0.75);
+        const double fence = 1.5 * (q3 - q1);
+
+        for (double s : sorted)
+            if (s >= q1 - fence && s <= q3 + fence)
+                result.accepted.push_back(s);
+        result.outliers = sorted.size() - result.accepted.size();
+
+        const auto& a = result.accepted;
+        double sum = 0;
+        for (double s : a)
+            sum += s;
+        result.mean = sum / static_cast<double>(a.size());
+
+        double sq = 0;
+        for (double s : a)
+            sq += (s - result.mean) * (s - result.mean);
+        result.stddev = (a.size() > 1) ? std::sqrt(sq / static_cast<double>(a.size() - 1)) : 0.0;
+
+        result.median = detail::percentile_of_sorted(a, 0.5);
+        result.min = a.front();
+        result.max = a.back();
+
+        return result;
+    }
+
+    template <typename F>
+    Result run(std::string name, F&& f, const Options& options = {})
+    {
+        const double min_sample = options.min_sample_time.count();
+
+        // warm-up: caches, branch predictors, page faults, CPU frequency
+        const double warmup_start = detail::steady_seconds();
+        do
+            f();
+        while (detail::steady_seconds() - warmup_start < options.warmup.count());
+
+        // calibration: grow the iteration count (doubling, or extrapolating from a run long enough to time)
+        // until one sample takes at least min_sample_time
+        uint64_t iterations = 1;
+        while (iterations < options.max_iterations)
+        {
+            const double elapsed = detail::time_iterations(f, iterations, options.clock);
+            if (elapsed >= min_sample)
+                break;
+
+            // jump close to the target when the run was long enough to extrapolate from
+            const double factor = (elapsed > min_sample / 100) ? min_sample / elapsed : 10.0;
+            iterations = std::min(options.max_iterations, std::max(iterations * 2, static_cast<uint64_t>(static_cast<double>(iterations) * factor * 1.2)));
+        }
+
+        std::vector<double> samples;
+        samples.reserve(options.samples);
+        for (size_t s = 0; s < std::max<size_t>(options.samples, 1); ++s)
+            samples.push_back(detail::time_iterations(f, iterations, options.clock) / static_cast<double>(iterations));
+
+        return analyze(std::move(name), std::move(samples), iterations);
+    }
+
+    // single timed call, for work too long (or not repeatable) to be sampled - seconds
+    template <typename F>
+    double time_once(F&& f, Clock clock = Clock::steady)
+    {
+        return detail::time_iterations(f, 1, clock);
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    // reporting
+
+    // human-readable duration: 12.3ns, 4.56us, 7.89ms, 1.23s
+    inline std::string format_duration(double seconds)
+    {
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(2);
+        if (seconds < 1e-6)
+            out << seconds * 1e9 << "ns";
+        else if (seconds < 1e-3)
+            out << seconds * 1e6 << "us";
+        else if (seconds < 1)
+            out << seconds * 1e3 << "ms";
+        else
+            out << seconds << "s";
+        return out.str();
+    }
+
+    inline std::ostream& operator<<(std::ostream& out, const Result& r)
+    {
+        return out << r.name << ": median " << format_duration(r.median)
+                   << " (mean " << format_duration(r.mean) << " +- " << format_duration(r.stddev)
+                   << ", p90 " << format_duration(r.percentile(0.9))
+                   << ", min " << format_duration(r.min) << ", max " << format_duration(r.max) << ")"
+                   << " x" << r.iterations << " iterations, " << r.samples.size() << " samples, "
+                   << r.outliers << " outliers";
+    }
+
+    inline std::string json_escape(const std::string& text)
+    {
+        std::string escaped;
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\')
+                escaped += '\\';
+            if (static_cast<unsigned char>(c) < 0x20)
+                escaped += ' ';
+            else
+                escaped += c;
+        }
+        return escaped;
+    }
+
+    // {"benchmarks": [{"name": ..., "median_s": ..., ...}, ...]}
+    inline void write_json(std::ostream& out, const std::vector<Result>& results)
+    {
+        const auto flags = out.flags();
+        const auto precision = out.precision();
+
+        out << std::setprecision(6) << std::scientific << "{\n  \"benchmarks\": [\n";
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            const Result& r = results[i];
+            out << "    {\"name\": \"" << json_escape(r.name) << "\", \"iterations\": " << r.iterations
+                << ", \"samples\": " << r.samples.size() << ", \"outliers\": " << r.outliers
+                << ", \"median_s\": " << r.median << ", \"mean_s\": " << r.mean << ", \"stddev_s\": " << r.stddev
+                << ", \"min_s\": " << r.min << ", \"max_s\": " << r.max
+                << ", \"p10_s\": " << r.percentile(0.1) << ", \"p90_s\": " << r.percentile(0.9)
+                << ", \"p99_s\": " << r.percentile(0.99) << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        out << "  ]\n}\n";
+
+        out.flags(flags);
+        out.precision(precision);
+    }
+}
+
+#endif
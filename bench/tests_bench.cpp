@@ -0,0 +1,93 @@
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <cmath>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench.hpp"
+
+using namespace std::literals;
+
+TEST_CASE("analyze")
+{
+    SECTION("statistics")
+    {
+        const bench::Result r = bench::analyze("five", {5, 1, 4, 2, 3});
+
+        CHECK(r.outliers == 0);
+        CHECK(r.median == 3);
+        CHECK(r.mean == 3);
+        CHECK(std::abs(r.stddev - std::sqrt(2.5)) < 1e-12);
+        CHECK(r.min == 1);
+        CHECK(r.max == 5);
+        CHECK(r.percentile(0.0) == 1);
+        CHECK(r.percentile(0.25) == 2);
+        CHECK(r.percentile(0.9) == 4.6);
+    }
+
+    SECTION("outliers outside the Tukey fences are rejected")
+    {
+        const bench::Result r = bench::analyze("spike", {10, 11, 10, 12, 11, 10, 500});
+
+        CHECK(r.outliers == 1);
+        CHECK(r.samples.size() == 7);
+        CHECK(r.max == 12);
+        CHECK(r.mean < 12);
+    }
+}
+
+TEST_CASE("run")
+{
+    bench::Options options;
+    options.warmup = 1ms;
+    options.min_sample_time = 2ms;
+    options.samples = 5;
+
+    SECTION("calibrates the iteration count")
+    {
+        int counter = 0;
+        const bench::Result r = bench::run("increment", [&] { bench::do_not_optimize(++counter); }, options);
+
+        CHECK(r.iterations > 1000);
+        CHECK(r.samples.size() == 5);
+        CHECK(r.median > 0);
+        CHECK(r.median < 1e-6);
+    }
+
+    SECTION("slow functions get few iterations")
+    {
+        const bench::Result r = bench::run("sleep", [] { std::this_thread::sleep_for(1ms); }, options);
+
+        CHECK(r.iterations <= 4);
+        CHECK(r.median >= 1e-3);
+    }
+
+    SECTION("time stamp counter")
+    {
+        options.clock = bench::Clock::tsc;
+        const bench::Result r = bench::run("sleep", [] { std::this_thread::sleep_for(1ms); }, options);
+
+        CHECK(r.median >= 0.9e-3);
+        CHECK(r.median < 50e-3);
+    }
+}
+
+TEST_CASE("reporting")
+{
+    const bench::Result r = bench::analyze("list \"push_back\"", {1e-6, 2e-6, 3e-6});
+
+    CHECK(bench::format_duration(1.5e-9) == "1.50ns");
+    CHECK(bench::format_duration(2e-6) == "2.00us");
+    CHECK(bench::format_duration(0.25) == "250.00ms");
+
+    std::ostringstream text;
+    text << r;
+    CHECK(text.str().find("median 2.00us") != std::string::npos);
+
+    std::ostringstream json;
+    bench::write_json(json, {r, r});
+    CHECK(json.str().find("\"name\": \"list \\\"push_back\\\"\"") != std::string::npos);
+    CHECK(json.str().find("\"median_s\": 2.000000e-06") != std::string::npos);
+}
@@ -1,4 +1,5 @@
 #include <catch2/catch_test_macros.hpp>
+#include "bench.hpp"
 #include "gadget.hpp"
 
 //#define MSVC
@@ -88,9 +89,7 @@ decltype(auto) call(F&& f, TArg&&... arg)
 template< int tries = 1, typename F, typename... Args  >
 auto timing(F&& f, Args&&... args)
 {
-    auto start = std::chrono::steady_clock::now();
-    for (int i{ 0 }; i < tries; ++i) std::invoke(f, std::forward<Args>(args)...);
-    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); // value in seconds
+    return bench::time_once([&] { for (int i{ 0 }; i < tries; ++i) std::invoke(f, std::forward<Args>(args)...); }); // value in seconds
 }
 
 void foo(int)
@@ -0,0 +1,150 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "calc_hits.hpp"
+#include "per_thread.hpp"
+#include "perf_counter.hpp"
+#include "rng.hpp"
+
+using namespace std;
+
+struct ReductionResult
+{
+    double ns_per_sample;
+    std::optional<uint64_t> cache_misses;
+    double pi;
+};
+
+// plain load + store of the slot on every sample - what `hits += hit` inside the sampling loop
+// compiles to when the compiler cannot keep the counter in a register
+inline void add_to_slot(uintmax_t& slot, uintmax_t hit)
+{
+    std::atomic_ref<uintmax_t> ref{slot};
+    ref.store(ref.load(std::memory_order_relaxed) + hit, std::memory_order_relaxed);
+}
+
+template <typename OnSample>
+void for_each_sample(Xoshiro256StarStar& rnd_gen, uintmax_t count, OnSample on_sample)
+{
+    for (uintmax_t n = 0; n < count; ++n)
+    {
+        const double x = uniform_double(rnd_gen);
+        const double y = uniform_double(rnd_gen);
+        on_sample(x * x + y * y < 1 ? 1 : 0);
+    }
+}
+
+template <typename Worker, typename Total>
+ReductionResult run_reduction(size_t no_of_threads, uintmax_t samples_per_thread, Worker worker, Total total)
+{
+    const auto streams = make_streams(default_seed, no_of_threads);
+
+    CacheMissCounter cache_misses;
+    const auto start = chrono::steady_clock::now();
+
+    std::vector<std::thread> thds;
+    for (size_t i = 0; i < no_of_threads; ++i)
+        thds.emplace_back([&, i] {
+            Xoshiro256StarStar rnd_gen = streams[i];
+            worker(i, rnd_gen, samples_per_thread);
+        });
+
+    for (auto& thd : thds)
+        thd.join();
+
+    const auto end = chrono::steady_clock::now();
+
+    const double N = static_cast<double>(samples_per_thread * no_of_threads);
+    const double elapsed_ns = chrono::duration<double, std::nano>(end - start).count();
+
+    return {elapsed_ns / N, cache_misses.read(), static_cast<double>(total()) / N * 4};
+}
+
+ReductionResult local_then_add(size_t no_of_threads, uintmax_t samples_per_thread)
+{
+    std::atomic<uintmax_t> hits = 0;
+
+    return run_reduction(no_of_threads, samples_per_thread,
+        [&](size_t, Xoshiro256StarStar& rnd_gen, uintmax_t count) {
+            uintmax_t local_hits = 0;
+            for_each_sample(rnd_gen, count, [&](uintmax_t hit) { local_hits += hit; });
+            hits += local_hits;
+        },
+        [&] { return hits.load(); });
+}
+
+ReductionResult partial_array(size_t no_of_threads, uintmax_t samples_per_thread)
+{
+    std::vector<uintmax_t> partial_hits(no_of_threads);
+
+    return run_reduction(no_of_threads, samples_per_thread,
+        [&](size_t id, Xoshiro256StarStar& rnd_gen, uintmax_t count) {
+            for_each_sample(rnd_gen, count, [&](uintmax_t hit) { add_to_slot(partial_hits[id], hit); });
+        },
+        [&] { return std::accumulate(partial_hits.begin(), partial_hits.end(), uintmax_t{0}); });
+}
+
+ReductionResult shared_atomic(size_t no_of_threads, uintmax_t samples_per_thread)
+{
+    std::atomic<uintmax_t> hits = 0;
+
+    return run_reduction(no_of_threads, samples_per_thread,
+        [&](size_t, Xoshiro256StarStar& rnd_gen, uintmax_t count) {
+            for_each_sample(rnd_gen, count, [&](uintmax_t hit) { hits.fetch_add(hit, std::memory_order_relaxed); });
+        },
+        [&] { return hits.load(); });
+}
+
+ReductionResult padded(size_t no_of_threads, uintmax_t samples_per_thread)
+{
+    PerThread<uintmax_t> hits(no_of_threads);
+
+    return run_reduction(no_of_threads, samples_per_thread,
+        [&](size_t id, Xoshiro256StarStar& rnd_gen, uintmax_t count) {
+            for_each_sample(rnd_gen, count, [&](uintmax_t hit) { add_to_slot(hits.local(id), hit); });
+        },
+        [&] { return hits.combine(); });
+}
+
+int main(int argc, char* argv[])
+{
+    const size_t max_threads = (argc > 1) ? std::stoul(argv[1]) : std::max(1u, std::thread::hardware_concurrency());
+    const uintmax_t samples_per_thread = (argc > 2) ? std::stoull(argv[2]) : 10'000'000;
+
+    struct Strategy
+    {
+        const char* name;
+        ReductionResult (*run)(size_t, uintmax_t);
+    };
+
+    const Strategy strategies[] = {
+        {"local-then-add", &local_then_add},
+        {"partial-array", &partial_array},
+        {"atomic", &shared_atomic},
+        {"padded", &padded},
+    };
+
+    cout << "samples per thread: " << samples_per_thread << "\n";
+    cout << left << setw(16) << "strategy" << right << setw(8) << "threads" << setw(14) << "ns/sample"
+         << setw(16) << "cache-misses" << setw(12) << "pi" << "\n";
+
+    for (size_t no_of_threads = 1; no_of_threads <= max_threads; ++no_of_threads)
+        for (const auto& strategy : strategies)
+        {
+            const ReductionResult result = strategy.run(no_of_threads, samples_per_thread);
+
+            cout << left << setw(16) << strategy.name << right << setw(8) << no_of_threads
+                 << setw(14) << fixed << setprecision(3) << result.ns_per_sample
+                 << setw(16) << (result.cache_misses ? std::to_string(*result.cache_misses) : "n/a")
+                 << setw(12) << setprecision(6) << result.pi << "\n";
+        }
+}
@@ -0,0 +1,532 @@
+#include "big_int.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <stdexcept>
+#include <utility>
+
+namespace
+{
+    using Limb = BigInt::Limb;
+    using Limbs = std::vector<Limb>;
+
+    constexpr uint64_t base = BigInt::base;
+
+    // operand sizes (in limbs) where the next algorithm starts to win - measured with pi_tests --engine chudnovsky
+    constexpr size_t karatsuba_threshold = 40;
+    constexpr size_t fft_threshold = 300;
+
+    void trim(Limbs& x)
+    {
+        while (!x.empty() && x.back() == 0)
+            x.pop_back();
+    }
+
+    int compare_mag(const Limbs& a, const Limbs& b)
+    {
+        if (a.size() != b.size())
+            return a.size() < b.size() ? -1 : 1;
+
+        for (size_t i = a.size(); i-- > 0;)
+            if (a[i] != b[i])
+                return a[i] < b[i] ? -1 : 1;
+
+        return 0;
+    }
+
+    // a += b * base^shift
+    void add_to(Limbs& a, const Limb* b, size_t nb, size_t shift = 0)
+    {
+        if (a.size() < nb + shift)
+            a.resize(nb + shift, 0);
+
+        Limb carry = 0;
+        size_t i = shift;
+        for (size_t j = 0; j < nb; ++i, ++j)
+        {
+            Limb sum = a[i] + b[j] + carry; // < 2 * 10^9 + 1 - fits in 32 bits
+            carry = (sum >= base);
+            a[i] = carry ? sum - static_cast<Limb>(base) : sum;
+        }
+
+        for (; carry; ++i)
+        {
+            if (i == a.size())
+                a.push_back(0);
+            Limb sum = a[i] + carry;
+            carry = (sum >= base);
+            a[i] = carry ? sum - static_cast<Limb>(base) : sum;
+        }
+    }
+
+    void add_to(Limbs& a, const Limbs& b, size_t shift = 0)
+    {
+        add_to(a, b.data(), b.size(), shift);
+    }
+
+    // a -= b * base^shift, requires a >= b * base^shift
+    void sub_from(Limbs& a, const Limbs& b, size_t shift = 0)
+    {
+        Limb borrow = 0;
+        size_t i = shift;
+        for (size_t j = 0; j < b.size(); ++i, ++j)
+        {
+            const uint64_t subtrahend = uint64_t{b[j]} + borrow;
+            borrow = (a[i] < subtrahend);
+            a[i] = static_cast<Limb>(a[i] + (borrow ? base : 0) - subtrahend);
+        }
+
+        for (; borrow; ++i)
+        {
+            borrow = (a[i] == 0);
+            a[i] = borrow ? static_cast<Limb>(base - 1) : a[i] - 1;
+        }
+
+        trim(a);
+    }
+
+    Limbs mul_schoolbook(const Limb* a, size_t na, const Limb* b, size_t nb)
+    {
+        if (na == 0 || nb == 0)
+            return {};
+
+        Limbs r(na + nb, 0);
+        for (size_t i = 0; i < na; ++i)
+        {
+            const uint64_t ai = a[i];
+            if (ai == 0)
+                continue;
+
+            uint64_t carry = 0;
+            for (size_t j = 0; j < nb; ++j)
+            {
+                const uint64_t cur = r[i + j] + ai * b[j] + carry; // < 10^18 + 2 * 10^9
+                r[i + j] = static_cast<Limb>(cur % base);
+                carry = cur / base;
+            }
+
+            for (size_t k = i + nb; carry; ++k)
+            {
+                const uint64_t cur = r[k] + carry;
+                r[k] = static_cast<Limb>(cur % base);
+                carry = cur / base;
+            }
+        }
+
+        trim(r);
+        return r;
+    }
+
+    Limbs mul_karatsuba(const Limb* a, size_t na, const Limb* b, size_t nb)
+    {
+        while (na > 0 && a[na - 1] == 0)
+            --na;
+        while (nb > 0 && b[nb - 1] == 0)
+            --nb;
+
+        if (na < nb)
+        {
+            std::swap(a, b);
+            std::swap(na, nb);
+        }
+
+        if (nb < karatsuba_threshold)
+            return mul_schoolbook(a, na, b, nb);
+
+        const size_t m = (na + 1) / 2;
+
+        if (nb <= m) // unbalanced - split only the longer operand
+        {
+            Limbs r = mul_karatsuba(a, m, b, nb);
+            const Limbs high = mul_karatsuba(a + m, na - m, b, nb);
+            add_to(r, high, m);
+            return r;
+        }
+
+        // (a1 B^m + a0)(b1 B^m + b0) = z2 B^2m + ((a0 + a1)(b0 + b1) - z0 - z2) B^m + z0
+        const Limbs z0 = mul_karatsuba(a, m, b, m);
+        const Limbs z2 = mul_karatsuba(a + m, na - m, b + m, nb - m);
+
+        Limbs sa(a, a + m);
+        add_to(sa, a + m, na - m);
+        Limbs sb(b, b + m);
+        add_to(sb, b + m, nb - m);
+
+        Limbs z1 = mul_karatsuba(sa.data(), sa.size(), sb.data(), sb.size());
+        sub_from(z1, z0);
+        sub_from(z1, z2);
+
+        Limbs r = z0;
+        add_to(r, z1, m);
+        add_to(r, z2, 2 * m);
+        trim(r);
+        return r;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    // FFT multiplication - every limb is split into three base-1000 digits, so convolution terms
+    // stay below n * 10^6 and round exactly in double precision for operands of many millions of digits
+
+    struct Complex
+    {
+        double re, im;
+    };
+
+    // written out - std::complex<double>::operator* checks for NaN/inf and is several times slower
+    inline Complex operator*(Complex a, Complex b) { return {a.re * b.re - a.im * b.im, a.re * b.im + a.im * b.re}; }
+    inline Complex operator+(Complex a, Complex b) { return {a.re + b.re, a.im + b.im}; }
+    inline Complex operator-(Complex a, Complex b) { return {a.re - b.re, a.im - b.im}; }
+    inline Complex conj(Complex a) { return {a.re, -a.im}; }
+
+    std::vector<Complex> make_roots(size_t n)
+    {
+        std::vector<Complex> roots(n / 2);
+        for (size_t k = 0; k < n / 2; ++k)
+        {
+            const double angle = 2 * std::numbers::pi * static_cast<double>(k) / static_cast<double>(n);
+            roots[k] = {std::cos(angle), std::sin(angle)};
+        }
+        return roots;
+    }
+
+    void fft(std::vector<Complex>& a, const std::vector<Complex>& roots, bool invert)
+    {
+        const size_t n = a.size();
+
+        for (size_t i = 1, j = 0; i < n; ++i)
+        {
+            size_t bit = n >> 1;
+            for (; j & bit; bit >>= 1)
+                j ^= bit;
+            j ^= bit;
+
+            if (i < j)
+                std::swap(a[i], a[j]);
+        }
+
+        for (size_t len = 2; len <= n; len <<= 1)
+        {
+            const size_t half = len / 2;
+            const size_t step = n / len;
+
+            for (size_t i = 0; i < n; i += len)
+                for (size_t j = 0; j < half; ++j)
+                {
+                    const Complex w = invert ? conj(roots[j * step]) : roots[j * step];
+                    const Complex u = a[i + j];
+                    const Complex v = a[i + j + half] * w;
+                    a[i + j] = u + v;
+                    a[i + j + half] = u - v;
+                }
+        }
+
+        if (invert)
+            for (auto& x : a)
+                x = {x.re / static_cast<double>(n), x.im / static_cast<double>(n)};
+    }
+
+    Limbs mul_fft(const Limbs& a, const Limbs& b)
+    {
+        if (a.empty() || b.empty())
+            return {};
+
+        constexpr uint32_t digit_base = 1000;
+        constexpr uint32_t digit_scale[3] = {1, 1000, 1'000'000};
+
+        const size_t da = a.size() * 3;
+        const size_t db = b.size() * 3;
+
+        size_t n = 1;
+        while (n < da + db)
+            n <<= 1;
+
+        // a in the real part, b in the imaginary part - one forward transform for both operands
+        std::vector<Complex> f(n, Complex{0, 0});
+        for (size_t i = 0; i < da; ++i)
+            f[i].re = (a[i / 3] / digit_scale[i % 3]) % digit_base;
+        for (size_t i = 0; i < db; ++i)
+            f[i].im = (b[i / 3] / digit_scale[i % 3]) % digit_base;
+
+        const std::vector<Complex> roots = make_roots(n);
+        fft(f, roots, false);
+
+        // A[k] B[k] = (F[k]^2 - conj(F[n-k])^2) / 4i
+        std::vector<Complex> p(n);
+        for (size_t k = 0; k < n; ++k)
+        {
+            const Complex fk = f[k];
+            const Complex fj = conj(f[(n - k) & (n - 1)]);
+            p[k] = (fk * fk - fj * fj) * Complex{0, -0.25};
+        }
+
+        fft(p, roots, true);
+
+        Limbs r((da + db) / 3 + 2, 0);
+        uint64_t carry = 0;
+        size_t i = 0;
+        for (; i < da + db; ++i)
+        {
+            const uint64_t value = static_cast<uint64_t>(std::llround(p[i].re)) + carry;
+            carry = value / digit_base;
+            r[i / 3] += static_cast<Limb>(value % digit_base) * digit_scale[i % 3];
+        }
+
+        for (; carry; ++i)
+        {
+            r[i / 3] += static_cast<Limb>(carry % digit_base) * digit_scale[i % 3];
+            carry /= digit_base;
+        }
+
+        trim(r);
+        return r;
+    }
+
+    Limbs mul_mag(const Limbs& a, const Limbs& b, MulAlgorithm algorithm)
+    {
+        switch (algorithm)
+        {
+        case MulAlgorithm::schoolbook:
+            return mul_schoolbook(a.data(), a.size(), b.data(), b.size());
+        case MulAlgorithm::karatsuba:
+            return mul_karatsuba(a.data(), a.size(), b.data(), b.size());
+        case MulAlgorithm::fft:
+            return mul_fft(a, b);
+        case MulAlgorithm::automatic:
+            break;
+        }
+
+        const size_t smaller = std::min(a.size(), b.size());
+
+        if (smaller < karatsuba_threshold)
+            return mul_schoolbook(a.data(), a.size(), b.data(), b.size());
+        if (smaller < fft_threshold)
+            return mul_karatsuba(a.data(), a.size(), b.data(), b.size());
+        return mul_fft(a, b);
+    }
+}
+
+BigInt::BigInt(int64_t value)
+    : negative_{value < 0}
+{
+    uint64_t mag = negative_ ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+    while (mag > 0)
+    {
+        mag_.push_back(static_cast<Limb>(mag % base));
+        mag /= base;
+    }
+}
+
+BigInt::BigInt(std::string_view decimal)
+{
+    bool negative = false;
+    if (!decimal.empty() && (decimal.front() == '-' || decimal.front() == '+'))
+    {
+        negative = (decimal.front() == '-');
+        decimal.remove_prefix(1);
+    }
+
+    if (decimal.empty() || !std::all_of(decimal.begin(), decimal.end(), [](char c) { return c >= '0' && c <= '9'; }))
+        throw std::invalid_argument("BigInt: not a decimal number");
+
+    for (size_t end = decimal.size(); end > 0;)
+    {
+        const size_t begin = (end > base_digits) ? end - base_digits : 0;
+
+        Limb limb = 0;
+        for (size_t i = begin; i < end; ++i)
+            limb = limb * 10 + static_cast<Limb>(decimal[i] - '0');
+        mag_.push_back(limb);
+
+        end = begin;
+    }
+
+    negative_ = negative;
+    trim();
+}
+
+std::string BigInt::to_string() const
+{
+    if (is_zero())
+        return "0";
+
+    std::string result = negative_ ? "-" : "";
+    result += std::to_string(mag_.back());
+
+    for (size_t i = mag_.size() - 1; i-- > 0;)
+    {
+        const std::string limb = std::to_string(mag_[i]);
+        result.append(base_digits - limb.size(), '0');
+        result += limb;
+    }
+
+    return result;
+}
+
+BigInt BigInt::operator-() const
+{
+    BigInt result = *this;
+    if (!result.is_zero())
+        result.negative_ = !negative_;
+    return result;
+}
+
+BigInt& BigInt::operator+=(const BigInt& other)
+{
+    if (negative_ == other.negative_)
+        add_to(mag_, other.mag_);
+    else if (compare_mag(mag_, other.mag_) >= 0)
+        sub_from(mag_, other.mag_);
+    else
+    {
+        Limbs mag = other.mag_;
+        sub_from(mag, mag_);
+        mag_ = std::move(mag);
+        negative_ = other.negative_;
+    }
+
+    trim();
+    return *this;
+}
+
+BigInt& BigInt::operator-=(const BigInt& other)
+{
+    return *this += -other;
+}
+
+BigInt& BigInt::operator*=(const BigInt& other)
+{
+    return *this = *this * other;
+}
+
+BigInt& BigInt::operator*=(uint32_t factor)
+{
+    uint64_t carry = 0;
+    for (auto& limb : mag_)
+    {
+        const uint64_t cur = limb * uint64_t{factor} + carry; // < 4.3 * 10^18 + carry
+        limb = static_cast<Limb>(cur % base);
+        carry = cur / base;
+    }
+
+    for (; carry; carry /= base)
+        mag_.push_back(static_cast<Limb>(carry % base));
+
+    trim();
+    return *this;
+}
+
+BigInt operator*(const BigInt& a, const BigInt& b)
+{
+    return multiply(a, b);
+}
+
+std::strong_ordering operator<=>(const BigInt& a, const BigInt& b)
+{
+    if (a.negative_ != b.negative_)
+        return a.negative_ ? std::strong_ordering::less : std::strong_ordering::greater;
+
+    const int cmp = a.negative_ ? compare_mag(b.mag_, a.mag_) : compare_mag(a.mag_, b.mag_);
+    return cmp <=> 0;
+}
+
+BigInt BigInt::shifted_limbs(ptrdiff_t k) const
+{
+    if (is_zero() || k == 0)
+        return *this;
+
+    BigInt result;
+    result.negative_ = negative_;
+
+    if (k > 0)
+    {
+        result.mag_.assign(static_cast<size_t>(k), 0);
+        result.mag_.insert(result.mag_.end(), mag_.begin(), mag_.end());
+    }
+    else if (static_cast<size_t>(-k) < mag_.size())
+        result.mag_.assign(mag_.begin() - k, mag_.end());
+
+    result.trim();
+    return result;
+}
+
+BigInt BigInt::from_limbs(std::vector<Limb> limbs, bool negative)
+{
+    BigInt result;
+    result.mag_ = std::move(limbs);
+    result.negative_ = negative;
+    result.trim();
+    return result;
+}
+
+void BigInt::trim()
+{
+    ::trim(mag_);
+    if (mag_.empty())
+        negative_ = false;
+}
+
+BigInt multiply(const BigInt& a, const BigInt& b, MulAlgorithm algorithm)
+{
+    return BigInt::from_limbs(mul_mag(a.limbs(), b.limbs(), algorithm), a.is_negative() != b.is_negative());
+}
+
+// Newton iteration x' = x + x (1 - u x) for u = x / base^size in [1/base, 1),
+// doubling the precision at every step
+BigInt reciprocal(const BigInt& x, size_t precision)
+{
+    if (x.is_zero())
+        throw std::domain_error("reciprocal of zero");
+
+    if (x.is_negative())
+        return -reciprocal(-x, precision);
+
+    const size_t t = x.size();
+    const auto& limbs = x.limbs();
+
+    if (precision <= 1)
+    {
+        double u = 0.0;
+        for (size_t i = 0; i < std::min<size_t>(t, 3); ++i)
+            u += limbs[t - 1 - i] * std::pow(static_cast<double>(base), -static_cast<double>(i + 1));
+
+        return BigInt(static_cast<int64_t>(std::pow(static_cast<double>(base), static_cast<double>(precision)) / u));
+    }
+
+    const size_t h = std::min(precision - 1, precision / 2 + 1);
+    const BigInt xh = reciprocal(x, h);
+
+    const auto p = static_cast<ptrdiff_t>(precision);
+    const auto hh = static_cast<ptrdiff_t>(h);
+
+    const BigInt u = x.shifted_limbs(p + 1 - static_cast<ptrdiff_t>(t)); // scale p + 1
+    const BigInt e = BigInt(1).shifted_limbs(p + 1 + hh) - u * xh;      // 1 - u xh, scale p + 1 + h
+    const BigInt correction = (xh * e).shifted_limbs(-(2 * hh + 1));    // scale p
+
+    return xh.shifted_limbs(p - hh) + correction;
+}
+
+// Newton iteration y' = y + y (1 - a y^2) / 2, doubling the precision at every step
+BigInt inverse_sqrt(uint32_t a, size_t precision)
+{
+    if (a == 0)
+        throw std::domain_error("inverse_sqrt of zero");
+
+    if (precision <= 1)
+        return BigInt(static_cast<int64_t>(std::pow(static_cast<double>(base), static_cast<double>(precision)) / std::sqrt(a)));
+
+    const size_t h = std::min(precision - 1, precision / 2 + 1);
+    const BigInt yh = inverse_sqrt(a, h);
+
+    const auto p = static_cast<ptrdiff_t>(precision);
+    const auto hh = static_cast<ptrdiff_t>(h);
+
+    BigInt ay2 = yh * yh; // scale 2h
+    ay2 *= a;
+    const BigInt e = BigInt(1).shifted_limbs(2 * hh) - ay2; // 1 - a y^2, scale 2h
+
+    BigInt half_correction = yh * e; // scale 3h
+    half_correction *= static_cast<uint32_t>(base / 2); // * base / 2 ...
+
+    return yh.shifted_limbs(p - hh) + half_correction.shifted_limbs(p - 3 * hh - 1); // ... / base
+}
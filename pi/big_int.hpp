@@ -0,0 +1,75 @@
+#ifndef BIG_INT_HPP
+#define BIG_INT_HPP
+
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Arbitrary precision signed integer.
+// Magnitude is stored as little-endian limbs in base 10^9, so conversion to decimal is linear in size.
+class BigInt
+{
+public:
+    using Limb = uint32_t;
+    static constexpr Limb base = 1'000'000'000;
+    static constexpr int base_digits = 9;
+
+    BigInt() = default;
+    BigInt(int64_t value);
+    explicit BigInt(std::string_view decimal);
+
+    bool is_zero() const { return mag_.empty(); }
+    bool is_negative() const { return negative_; }
+    size_t size() const { return mag_.size(); }
+    const std::vector<Limb>& limbs() const { return mag_; }
+
+    std::string to_string() const;
+
+    BigInt operator-() const;
+
+    BigInt& operator+=(const BigInt& other);
+    BigInt& operator-=(const BigInt& other);
+    BigInt& operator*=(const BigInt& other);
+    BigInt& operator*=(uint32_t factor);
+
+    friend BigInt operator+(BigInt a, const BigInt& b) { return a += b; }
+    friend BigInt operator-(BigInt a, const BigInt& b) { return a -= b; }
+    friend BigInt operator*(const BigInt& a, const BigInt& b);
+
+    friend bool operator==(const BigInt&, const BigInt&) = default;
+    friend std::strong_ordering operator<=>(const BigInt& a, const BigInt& b);
+
+    // multiplies by base^k for k > 0, divides by base^-k (truncating towards zero) for k < 0
+    BigInt shifted_limbs(ptrdiff_t k) const;
+
+    static BigInt from_limbs(std::vector<Limb> limbs, bool negative = false);
+
+private:
+    std::vector<Limb> mag_; // no leading zero limbs; empty for 0
+    bool negative_ = false;
+
+    void trim();
+};
+
+enum class MulAlgorithm
+{
+    automatic,
+    schoolbook,
+    karatsuba,
+    fft
+};
+
+BigInt multiply(const BigInt& a, const BigInt& b, MulAlgorithm algorithm = MulAlgorithm::automatic);
+
+// fixed-point helpers (value = X / base^precision)
+
+// X ~ base^(x.size() + precision) / x, with an error of a few units in the last limb
+BigInt reciprocal(const BigInt& x, size_t precision);
+
+// X ~ base^precision / sqrt(a), with an error of a few units in the last limb
+BigInt inverse_sqrt(uint32_t a, size_t precision);
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef CALC_HITS_HPP
+#define CALC_HITS_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <execution>
+#include <functional>
+#include <numeric>
+#include <vector>
+
+#include "per_thread.hpp"
+#include "rng.hpp"
+#include "simd_hits.hpp"
+#include "work_stealing.hpp"
+
+constexpr uint64_t default_seed = 2023;
+
+template <typename RndGen>
+uintmax_t count_hits(RndGen& rnd_gen, const uintmax_t count)
+{
+    uintmax_t local_hits = 0;
+    for (uintmax_t n = 0; n < count; ++n)
+    {
+        double x = uniform_double(rnd_gen);
+        double y = uniform_double(rnd_gen);
+
+        if (x * x + y * y < 1)
+            local_hits++;
+    }
+
+    return local_hits;
+}
+
+template <typename RndGen = Xoshiro256StarStar>
+void calc_hits(const uintmax_t count, uintmax_t& hits, RndGen rnd_gen = RndGen{default_seed})
+{
+    hits += count_hits(rnd_gen, count);
+}
+
+template <typename RndGen = Xoshiro256StarStar>
+void calc_hits(const uintmax_t count, std::atomic<uintmax_t>& hits, RndGen rnd_gen = RndGen{default_seed})
+{
+    hits += count_hits(rnd_gen, count);
+}
+
+// Every block draws from its own generator (block_generator), set up when the block is claimed - so the result
+// depends only on (count, seed, block_size), not on the number of threads or on which worker got which block,
+// and setup is O(1) per block instead of one generator per block materialized up front.
+template <typename RndGen = Xoshiro256StarStar>
+uintmax_t calc_hits_work_stealing(const uintmax_t count, size_t no_of_threads, uint64_t seed = default_seed,
+    uintmax_t block_size = 1 << 16, const std::vector<unsigned>& cpus = {})
+{
+    no_of_threads = std::max<size_t>(no_of_threads, 1);
+    block_size = std::max<uintmax_t>(block_size, 1);
+
+    NodeLocal<uintmax_t> hits(no_of_threads);
+
+    run_work_stealing(count, block_size, no_of_threads, [&](size_t id, const SampleBlock& block) {
+        RndGen rnd_gen = block_generator<RndGen>(seed, block.first / block_size);
+        hits.local(id) += count_hits(rnd_gen, block.count);
+    }, cpus);
+
+    return hits.combine();
+}
+
+inline uintmax_t calc_hits_simd(const uintmax_t count, size_t no_of_threads, uint64_t seed = default_seed,
+    uintmax_t block_size = 1 << 20, const std::vector<unsigned>& cpus = {})
+{
+    no_of_threads = std::max<size_t>(no_of_threads, 1);
+
+    NodeLocal<uintmax_t> hits(no_of_threads);
+
+    run_work_stealing(count, block_size, no_of_threads, [&](size_t id, const SampleBlock& block) {
+        hits.local(id) += count_hits_simd(seed, block.first, block.count);
+    }, cpus);
+
+    return hits.combine();
+}
+
+// The same blocks and counter-based stream as calc_hits_simd, scheduled by the standard parallel algorithms
+// (TBB backend with libstdc++) instead of hand-rolled threads - both return identical hits.
+inline uintmax_t calc_hits_transform_reduce(const uintmax_t count, uint64_t seed = default_seed, uintmax_t block_size = 1 << 20)
+{
+    block_size = std::max<uintmax_t>(block_size, 1);
+
+    std::vector<uintmax_t> blocks((count + block_size - 1) / block_size);
+    std::iota(blocks.begin(), blocks.end(), uintmax_t{0});
+
+    // resolved up front - the element function must not hit the guarded static inside best_simd_path()
+    const SimdPath path = best_simd_path();
+
+    return std::transform_reduce(std::execution::par_unseq, blocks.begin(), blocks.end(), uintmax_t{0}, std::plus<>{},
+        [=](uintmax_t b) {
+            const uintmax_t first = b * block_size;
+            return count_hits_simd(path, seed, first, std::min(block_size, count - first));
+        });
+}
+
+#endif
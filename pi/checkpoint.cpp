@@ -0,0 +1,288 @@
+#include "checkpoint.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "rng.hpp"
+
+namespace
+{
+    constexpr char magic[8] = {'P', 'I', 'C', 'K', 'P', 'T', '\0', '\0'};
+    constexpr uint32_t version = 1;
+
+    uint64_t fnv1a(const std::vector<char>& bytes)
+    {
+        uint64_t hash = 0xcbf29ce484222325ULL;
+        for (char c : bytes)
+        {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 0x100000001b3ULL;
+        }
+        return hash;
+    }
+
+    template <typename T>
+    void put(std::vector<char>& bytes, const T& value)
+    {
+        const char* raw = reinterpret_cast<const char*>(&value);
+        bytes.insert(bytes.end(), raw, raw + sizeof(T));
+    }
+
+    class Reader
+    {
+        const std::vector<char>& bytes_;
+        size_t pos_ = 0;
+
+    public:
+        explicit Reader(const std::vector<char>& bytes)
+            : bytes_{bytes}
+        {
+        }
+
+        template <typename T>
+        T get()
+        {
+            if (bytes_.size() - pos_ < sizeof(T))
+                throw std::runtime_error("checkpoint file is truncated");
+
+            T value;
+            std::memcpy(&value, bytes_.data() + pos_, sizeof(T));
+            pos_ += sizeof(T);
+            return value;
+        }
+
+        size_t position() const { return pos_; }
+    };
+
+    struct FileCloser
+    {
+        void operator()(std::FILE* f) const { std::fclose(f); }
+    };
+
+    // data and metadata on disk - without it a crash right after the rename may leave an empty or partial file
+    bool sync(std::FILE* f)
+    {
+#ifdef __linux__
+        return fsync(fileno(f)) == 0;
+#else
+        (void)f;
+        return true;
+#endif
+    }
+
+    // makes the rename itself durable
+    void sync_directory(const std::filesystem::path& dir)
+    {
+#ifdef __linux__
+        const int fd = open(dir.empty() ? "." : dir.c_str(), O_RDONLY | O_DIRECTORY);
+        if (fd != -1)
+        {
+            fsync(fd);
+            close(fd);
+        }
+#else
+        (void)dir;
+#endif
+    }
+}
+
+void save_checkpoint(const std::filesystem::path& file, const Checkpoint& checkpoint)
+{
+    std::vector<char> bytes(std::begin(magic), std::end(magic));
+    put(bytes, version);
+    put(bytes, static_cast<uint32_t>(checkpoint.workers.size()));
+    put(bytes, checkpoint.total_samples);
+    put(bytes, checkpoint.seed);
+
+    for (const auto& worker : checkpoint.workers)
+    {
+        put(bytes, worker.samples_done);
+        put(bytes, worker.hits);
+        for (uint64_t word : worker.rng_state)
+            put(bytes, word);
+    }
+
+    put(bytes, fnv1a(bytes));
+
+    std::filesystem::path tmp = file;
+    tmp += ".tmp";
+    {
+        std::unique_ptr<std::FILE, FileCloser> out{std::fopen(tmp.string().c_str(), "wb")};
+        if (!out || std::fwrite(bytes.data(), 1, bytes.size(), out.get()) != bytes.size() || std::fflush(out.get()) != 0
+            || !sync(out.get()))
+            throw std::runtime_error("cannot write checkpoint " + tmp.string());
+    }
+
+    std::filesystem::rename(tmp, file);
+    sync_directory(file.parent_path());
+}
+
+std::optional<Checkpoint> load_checkpoint(const std::filesystem::path& file)
+{
+    std::ifstream in{file, std::ios::binary};
+    if (!in)
+        return std::nullopt;
+
+    const std::vector<char> bytes{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+
+    if (bytes.size() < sizeof(magic) || !std::equal(std::begin(magic), std::end(magic), bytes.begin()))
+        throw std::runtime_error(file.string() + " is not a pi checkpoint");
+
+    Reader reader{bytes};
+    reader.get<std::array<char, sizeof(magic)>>();
+
+    if (reader.get<uint32_t>() != version)
+        throw std::runtime_error(file.string() + ": unsupported checkpoint version");
+
+    Checkpoint checkpoint;
+    const uint32_t no_of_workers = reader.get<uint32_t>();
+    checkpoint.total_samples = reader.get<uint64_t>();
+    checkpoint.seed = reader.get<uint64_t>();
+
+    if (no_of_workers == 0 || bytes.size() != reader.position() + no_of_workers * 6 * sizeof(uint64_t) + sizeof(uint64_t))
+        throw std::runtime_error(file.string() + ": checkpoint is truncated");
+
+    for (uint32_t i = 0; i < no_of_workers; ++i)
+    {
+        WorkerProgress worker;
+        worker.samples_done = reader.get<uint64_t>();
+        worker.hits = reader.get<uint64_t>();
+        for (auto& word : worker.rng_state)
+            word = reader.get<uint64_t>();
+        checkpoint.workers.push_back(worker);
+    }
+
+    const size_t payload = reader.position();
+    if (reader.get<uint64_t>() != fnv1a(std::vector<char>(bytes.begin(), bytes.begin() + payload)))
+        throw std::runtime_error(file.string() + ": checkpoint checksum mismatch");
+
+    return checkpoint;
+}
+
+std::optional<uintmax_t> calc_hits_checkpointed(uintmax_t count, size_t no_of_threads, uint64_t seed,
+    const std::filesystem::path& file, std::chrono::milliseconds interval, const std::atomic<bool>* stop,
+    uintmax_t block_size)
+{
+    block_size = std::max<uintmax_t>(block_size, 1);
+
+    Checkpoint checkpoint;
+    if (auto loaded = load_checkpoint(file))
+    {
+        if (loaded->total_samples != count || loaded->seed != seed)
+            throw std::runtime_error(file.string() + " belongs to a run with different samples or seed");
+        checkpoint = std::move(*loaded);
+    }
+    else
+    {
+        checkpoint = Checkpoint{count, seed, {}};
+        for (const auto& stream : make_streams(seed, std::max<size_t>(no_of_threads, 1)))
+            checkpoint.workers.push_back({0, 0, stream.state()});
+    }
+
+    const size_t no_of_workers = checkpoint.workers.size();
+
+    // fails here, before any work is done, if the checkpoint cannot be written
+    save_checkpoint(file, checkpoint);
+
+    std::mutex mtx; // guards checkpoint.workers and finished
+    std::condition_variable cv_finished;
+    size_t finished = 0;
+    std::atomic<bool> failed = false; // a save failed - the workers stop, the error is rethrown after joining them
+
+    auto stopped = [stop, &failed] { return (stop && stop->load(std::memory_order_relaxed)) || failed.load(std::memory_order_relaxed); };
+
+    std::vector<std::thread> thds;
+    for (size_t i = 0; i < no_of_workers; ++i)
+        thds.emplace_back([&, i] {
+            const uintmax_t slice = count * (i + 1) / no_of_workers - count * i / no_of_workers;
+
+            WorkerProgress progress;
+            {
+                std::lock_guard lk{mtx};
+                progress = checkpoint.workers[i];
+            }
+
+            Xoshiro256StarStar rnd_gen{progress.rng_state};
+            while (progress.samples_done < slice && !stopped())
+            {
+                const uintmax_t n = std::min(block_size, slice - progress.samples_done);
+                progress.hits += count_hits(rnd_gen, n);
+                progress.samples_done += n;
+                progress.rng_state = rnd_gen.state();
+
+                std::lock_guard lk{mtx};
+                checkpoint.workers[i] = progress;
+            }
+
+            std::lock_guard lk{mtx};
+            ++finished;
+            cv_finished.notify_one();
+        });
+
+    // this thread saves a snapshot every interval until all workers are done - written outside the lock,
+    // so the workers do not stall on the disk. *stop is set from a signal handler, which cannot notify
+    // a condition variable, so it is polled every stop_poll_interval.
+    constexpr auto stop_poll_interval = std::chrono::milliseconds{50};
+    std::exception_ptr error;
+    {
+        auto next_save = std::chrono::steady_clock::now() + interval;
+        std::unique_lock lk{mtx};
+        while (!cv_finished.wait_until(lk, std::min(next_save, std::chrono::steady_clock::now() + stop_poll_interval),
+            [&] { return finished == no_of_workers || stopped(); }))
+        {
+            if (std::chrono::steady_clock::now() < next_save)
+                continue;
+
+            const Checkpoint snapshot = checkpoint;
+            lk.unlock();
+            try
+            {
+                save_checkpoint(file, snapshot);
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+                failed = true;
+            }
+            lk.lock();
+            next_save = std::chrono::steady_clock::now() + interval;
+        }
+    }
+
+    for (auto& thd : thds)
+        thd.join();
+
+    if (error)
+        std::rethrow_exception(error);
+
+    bool complete = true;
+    for (size_t i = 0; i < no_of_workers; ++i)
+        complete = complete && checkpoint.workers[i].samples_done == count * (i + 1) / no_of_workers - count * i / no_of_workers;
+
+    if (!complete)
+    {
+        save_checkpoint(file, checkpoint);
+        return std::nullopt;
+    }
+
+    std::filesystem::remove(file);
+
+    uintmax_t hits = 0;
+    for (const auto& worker : checkpoint.workers)
+        hits += worker.hits;
+    return hits;
+}
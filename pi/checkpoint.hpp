@@ -0,0 +1,51 @@
+#ifndef CHECKPOINT_HPP
+#define CHECKPOINT_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <vector>
+
+#include "calc_hits.hpp"
+
+struct WorkerProgress
+{
+    uint64_t samples_done;
+    uint64_t hits;
+    std::array<uint64_t, 4> rng_state; // xoshiro256** state after samples_done samples
+
+    bool operator==(const WorkerProgress&) const = default;
+};
+
+struct Checkpoint
+{
+    uint64_t total_samples;
+    uint64_t seed;
+    std::vector<WorkerProgress> workers; // worker i owns samples [N * i / K, N * (i + 1) / K)
+
+    bool operator==(const Checkpoint&) const = default;
+};
+
+// Binary layout (native byte order): 8-byte magic, uint32 version, uint32 worker count, uint64 total samples,
+// uint64 seed, 6 x uint64 per worker, uint64 FNV-1a checksum of everything before it.
+// save_checkpoint writes a temporary file and renames it over the old one, so a crash while saving
+// leaves the previous checkpoint intact.
+void save_checkpoint(const std::filesystem::path& file, const Checkpoint& checkpoint);
+
+// nullopt if the file does not exist; throws std::runtime_error if it is truncated or corrupt
+std::optional<Checkpoint> load_checkpoint(const std::filesystem::path& file);
+
+// Monte Carlo hit count that survives being killed: worker progress is saved to `file` every `interval`
+// (and when *stop is set). A later call with the same file, count and seed resumes every worker exactly where
+// it stopped, using the saved number of workers - the result is identical to an uninterrupted run.
+// Returns nullopt if stopped early; on completion the checkpoint file is removed.
+// Throws std::runtime_error if the checkpoint cannot be written - checked before the workers start; a save that
+// fails later stops the workers and is rethrown once they have been joined.
+std::optional<uintmax_t> calc_hits_checkpointed(uintmax_t count, size_t no_of_threads, uint64_t seed,
+    const std::filesystem::path& file, std::chrono::milliseconds interval = std::chrono::seconds{10},
+    const std::atomic<bool>* stop = nullptr, uintmax_t block_size = 1 << 22);
+
+#endif
@@ -0,0 +1,179 @@
+#include "chudnovsky.hpp"
+
+#include <bit>
+#include <cstdint>
+#include <future>
+#include <stdexcept>
+#include <utility>
+
+#include "big_int.hpp"
+
+namespace
+{
+    // 640320^3 / 24
+    constexpr int64_t c3_over_24 = 10'939'058'860'032'000;
+
+    // log10(640320^3 / 1728) - decimal digits gained per term of the series
+    constexpr double digits_per_term = 14.181647462725477;
+
+    // P(a, b), Q(a, b), T(a, b) of the binary splitting scheme, with
+    // sum_{k=0}^{n-1} (-1)^k (6k)! (13591409 + 545140134k) / ((3k)! (k!)^3 640320^3k) = T(0, n) / Q(0, n)
+    struct Split
+    {
+        BigInt p;
+        BigInt q;
+        BigInt t;
+    };
+
+    Split leaf(uint64_t a)
+    {
+        Split s;
+
+        if (a == 0)
+        {
+            s.p = 1;
+            s.q = 1;
+        }
+        else
+        {
+            s.p = static_cast<int64_t>(6 * a - 5);
+            s.p *= static_cast<uint32_t>(2 * a - 1);
+            s.p *= static_cast<uint32_t>(6 * a - 1);
+
+            s.q = c3_over_24;
+            for (int i = 0; i < 3; ++i)
+                s.q *= static_cast<uint32_t>(a);
+        }
+
+        s.t = s.p;
+        s.t *= 13'591'409u;
+        BigInt linear = s.p;
+        linear *= 545'140'134u;
+        linear *= static_cast<uint32_t>(a);
+        s.t += linear;
+
+        if (a & 1)
+            s.t = -s.t;
+
+        return s;
+    }
+
+    // parallel_depth > 0 runs the left half and the merge products on their own threads;
+    // P is not needed for the rightmost chain of the recursion (including the root)
+    Split split(uint64_t a, uint64_t b, unsigned parallel_depth, bool need_p)
+    {
+        if (b - a == 1)
+            return leaf(a);
+
+        const uint64_t m = a + (b - a) / 2;
+
+        Split left, right;
+        if (parallel_depth > 0)
+        {
+            auto left_future = std::async(std::launch::async, split, a, m, parallel_depth - 1, true);
+            right = split(m, b, parallel_depth - 1, need_p);
+            left = left_future.get();
+        }
+        else
+        {
+            left = split(a, m, 0, true);
+            right = split(m, b, 0, need_p);
+        }
+
+        // P = Pl Pr, Q = Ql Qr, T = Tl Qr + Pl Tr
+        Split s;
+        if (parallel_depth > 0)
+        {
+            auto q = std::async(std::launch::async, [&] { return left.q * right.q; });
+            auto t = std::async(std::launch::async, [&] { return left.t * right.q; });
+            if (need_p)
+                s.p = left.p * right.p;
+            s.t = left.p * right.t;
+            s.t += t.get();
+            s.q = q.get();
+        }
+        else
+        {
+            if (need_p)
+                s.p = left.p * right.p;
+            s.q = left.q * right.q;
+            s.t = left.t * right.q;
+            s.t += left.p * right.t;
+        }
+
+        return s;
+    }
+
+    // floor(pi * 10^d) for the first 100 decimals, and its last 10 digits at larger d
+    constexpr std::string_view reference_prefix = "3."
+                                                  "1415926535897932384626433832795028841971693993751058209749445923078164062862089986280348253421170679";
+
+    struct Checkpoint
+    {
+        size_t digits;
+        std::string_view last_ten;
+    };
+
+    constexpr Checkpoint reference_checkpoints[] = {
+        {1'000, "2164201989"},
+        {10'000, "5256375678"},
+        {100'000, "5493624646"},
+        {1'000'000, "5779458151"},
+    };
+}
+
+std::string chudnovsky_pi(size_t digits, size_t no_of_threads)
+{
+    const uint64_t terms = static_cast<uint64_t>(static_cast<double>(digits) / digits_per_term) + 2;
+
+    const unsigned parallel_depth = (no_of_threads > 1) ? std::bit_width(no_of_threads - 1) : 0;
+    const Split s = split(0, terms, parallel_depth, false);
+
+    // pi = 426880 sqrt(10005) Q / T, evaluated as fixed point numbers with `precision` fraction limbs
+    const size_t precision = (digits + BigInt::base_digits - 1) / BigInt::base_digits + 2; // 2 guard limbs
+    const auto p = static_cast<ptrdiff_t>(precision);
+    const auto t_size = static_cast<ptrdiff_t>(s.t.size());
+
+    auto q_over_t_future = std::async(no_of_threads > 1 ? std::launch::async : std::launch::deferred, [&] {
+        return (s.q * reciprocal(s.t, precision + 2)).shifted_limbs(-(t_size + 2));
+    });
+    const BigInt inv_sqrt = inverse_sqrt(10005, precision);
+    const BigInt q_over_t = q_over_t_future.get();
+
+    BigInt pi = (q_over_t * inv_sqrt).shifted_limbs(-p);
+    pi *= 426'880u;
+    pi *= 10'005u;
+
+    if (pi.shifted_limbs(-p) != BigInt(3))
+        throw std::logic_error("chudnovsky_pi: integer part is not 3");
+
+    std::string result = "3.";
+    result.reserve(2 + precision * BigInt::base_digits);
+
+    const auto& limbs = pi.limbs();
+    for (size_t i = precision; i-- > 0;)
+    {
+        const std::string limb = (i < limbs.size()) ? std::to_string(limbs[i]) : "0";
+        result.append(BigInt::base_digits - limb.size(), '0');
+        result += limb;
+    }
+
+    result.resize(2 + digits);
+    return result;
+}
+
+bool verify_pi_digits(std::string_view pi)
+{
+    if (pi.size() < 2 || pi.substr(0, 2) != "3.")
+        return false;
+
+    const size_t digits = pi.size() - 2;
+    if (pi.substr(0, 2 + std::min(digits, reference_prefix.size() - 2)) != reference_prefix.substr(0, pi.size()))
+        return false;
+
+    for (const auto& checkpoint : reference_checkpoints)
+        if (checkpoint.digits <= digits && pi.substr(2 + checkpoint.digits - 10, 10) != checkpoint.last_ten)
+            return false;
+
+    return true;
+}
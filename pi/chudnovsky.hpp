@@ -0,0 +1,19 @@
+#ifndef CHUDNOVSKY_HPP
+#define CHUDNOVSKY_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <thread>
+
+// Decimal expansion of pi with `digits` digits after the decimal point ("3.14159...").
+// Chudnovsky series summed by binary splitting; the two halves of the upper levels of the
+// recursion and their merge products run on separate threads.
+std::string chudnovsky_pi(size_t digits, size_t no_of_threads = std::max(1u, std::thread::hardware_concurrency()));
+
+// Checks a "3.14159..." string against the reference digits compiled into the program
+// (the first 100 decimals and the last 10 of the first 10^3, 10^4, 10^5 and 10^6 decimals).
+bool verify_pi_digits(std::string_view pi);
+
+#endif
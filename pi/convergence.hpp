@@ -0,0 +1,122 @@
+#ifndef CONVERGENCE_HPP
+#define CONVERGENCE_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "calc_hits.hpp"
+#include "low_discrepancy.hpp"
+#include "rng.hpp"
+#include "work_stealing.hpp"
+
+enum class SampleSource
+{
+    pseudo_random,
+    halton,
+    sobol
+};
+
+inline std::string_view to_string(SampleSource source)
+{
+    switch (source)
+    {
+    case SampleSource::pseudo_random:
+        return "pseudo-random";
+    case SampleSource::halton:
+        return "halton";
+    case SampleSource::sobol:
+        return "sobol";
+    }
+
+    return "unknown";
+}
+
+struct ConvergenceResult
+{
+    double pi;
+    double std_error;
+    uintmax_t samples; // over all replicas
+    bool converged;
+};
+
+// Runs `replicas` independently randomized copies of the sample source (shifted QMC sequences or
+// independent RNG streams) and doubles the number of points per replica until
+// z * standard error of the mean estimate <= tolerance (z = 3, ~99.7% confidence) or max_samples is reached.
+// Points already counted are never recomputed - every round only adds the next [n, 2n) indices.
+inline ConvergenceResult estimate_pi_until(double tolerance, SampleSource source, uint64_t seed = default_seed,
+    uintmax_t max_samples = uintmax_t{1} << 34, size_t replicas = 16,
+    size_t no_of_threads = std::max(1u, std::thread::hardware_concurrency()))
+{
+    constexpr double z = 3.0;
+
+    replicas = std::max<size_t>(replicas, 2);
+
+    std::vector<SobolSequence<2>> sobol;
+    std::vector<HaltonSequence<2>> halton;
+    std::vector<Xoshiro256StarStar> streams = make_streams(seed, replicas);
+
+    SplitMix64 seeds{seed};
+    for (size_t r = 0; r < replicas; ++r)
+    {
+        sobol.emplace_back(seeds() | 1);
+        halton.emplace_back(seeds() | 1);
+    }
+
+    std::vector<uintmax_t> hits(replicas);
+    uintmax_t points_per_replica = 0;
+    uintmax_t batch = 1024;
+
+    while (true)
+    {
+        // replica r only touches hits[r] and its own generator
+        run_work_stealing(replicas, 1, no_of_threads, [&](size_t, const SampleBlock& block) {
+            const size_t r = static_cast<size_t>(block.first);
+            switch (source)
+            {
+            case SampleSource::pseudo_random:
+                hits[r] += count_hits(streams[r], batch);
+                break;
+            case SampleSource::halton:
+                hits[r] += count_hits_qmc(halton[r], points_per_replica, batch);
+                break;
+            case SampleSource::sobol:
+                hits[r] += count_hits_qmc(sobol[r], points_per_replica, batch);
+                break;
+            }
+        });
+
+        points_per_replica += batch;
+
+        double mean = 0.0;
+        for (uintmax_t h : hits)
+            mean += 4.0 * h / points_per_replica;
+        mean /= replicas;
+
+        double variance = 0.0;
+        for (uintmax_t h : hits)
+        {
+            const double estimate = 4.0 * h / points_per_replica;
+            variance += (estimate - mean) * (estimate - mean);
+        }
+        variance /= replicas - 1;
+
+        const double std_error = std::sqrt(variance / replicas);
+        const uintmax_t samples = points_per_replica * replicas;
+
+        if (z * std_error <= tolerance)
+            return {mean, std_error, samples, true};
+
+        const bool sequence_exhausted = (source == SampleSource::sobol) && (points_per_replica * 2 > SobolSequence<2>::max_points);
+
+        if (samples * 2 > max_samples || sequence_exhausted)
+            return {mean, std_error, samples, false};
+
+        batch = points_per_replica; // next round doubles the points per replica
+    }
+}
+
+#endif
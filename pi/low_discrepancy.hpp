@@ -0,0 +1,204 @@
+#ifndef LOW_DISCREPANCY_HPP
+#define LOW_DISCREPANCY_HPP
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+#include "rng.hpp"
+
+// Sobol sequence with Joe-Kuo (new-joe-kuo-6.21201) direction numbers, 32-bit resolution (up to 2^32 points).
+// Points are in Gray-code order (Antonov-Saleev): point i can be computed directly from gray(i),
+// and consecutive points differ by a single XOR per dimension.
+// Randomized with a digital shift (XOR) - every shift gives an unbiased estimator with the same low discrepancy.
+template <size_t Dim>
+class SobolSequence
+{
+    struct Polynomial
+    {
+        unsigned degree;
+        uint32_t coeffs;
+        std::array<uint32_t, 5> m;
+    };
+
+    // dimension 1 is van der Corput in base 2 - not listed
+    static constexpr std::array<Polynomial, 7> polynomials = {{
+        {1, 0, {1}},
+        {2, 1, {1, 3}},
+        {3, 1, {1, 3, 1}},
+        {3, 2, {1, 1, 1}},
+        {4, 1, {1, 1, 3, 3}},
+        {4, 4, {1, 3, 5, 13}},
+        {5, 2, {1, 1, 5, 5, 17}},
+    }};
+
+    static_assert(Dim >= 1 && Dim <= polynomials.size() + 1, "SobolSequence: unsupported number of dimensions");
+
+    static constexpr unsigned bits = 32;
+
+    std::array<std::array<uint32_t, bits>, Dim> directions_{};
+    std::array<uint32_t, Dim> shift_{};
+
+public:
+    static constexpr size_t dimensions = Dim;
+    static constexpr uint64_t max_points = uint64_t{1} << bits; // indices from here on have no direction numbers
+
+    explicit SobolSequence(uint64_t seed = 0)
+    {
+        for (unsigned k = 0; k < bits; ++k)
+            directions_[0][k] = uint32_t{1} << (bits - 1 - k);
+
+        for (size_t d = 1; d < Dim; ++d)
+        {
+            const Polynomial& p = polynomials[d - 1];
+            auto& v = directions_[d];
+
+            for (unsigned k = 0; k < p.degree; ++k)
+                v[k] = p.m[k] << (bits - 1 - k);
+
+            for (unsigned k = p.degree; k < bits; ++k)
+            {
+                v[k] = v[k - p.degree] ^ (v[k - p.degree] >> p.degree);
+                for (unsigned j = 1; j < p.degree; ++j)
+                    if ((p.coeffs >> (p.degree - 1 - j)) & 1)
+                        v[k] ^= v[k - j];
+            }
+        }
+
+        if (seed != 0)
+        {
+            SplitMix64 rnd_gen{seed};
+            for (auto& s : shift_)
+                s = static_cast<uint32_t>(rnd_gen() >> 32);
+        }
+    }
+
+    // throws std::out_of_range for index >= max_points
+    std::array<double, Dim> operator[](uint64_t index) const
+    {
+        if (index >= max_points)
+            throw std::out_of_range("SobolSequence: index beyond 2^32 points");
+        return to_point(integer_point(index));
+    }
+
+    // f(point) for points [first, first + count); throws std::out_of_range if they do not all lie below max_points
+    template <typename F>
+    void for_each_point(uint64_t first, uint64_t count, F f) const
+    {
+        if (first > max_points || count > max_points - first)
+            throw std::out_of_range("SobolSequence: points beyond 2^32");
+        if (count == 0)
+            return;
+
+        std::array<uint32_t, Dim> x = integer_point(first);
+        f(to_point(x));
+
+        for (uint64_t i = first + 1; i < first + count; ++i)
+        {
+            const unsigned k = static_cast<unsigned>(std::countr_zero(i));
+            for (size_t d = 0; d < Dim; ++d)
+                x[d] ^= directions_[d][k];
+            f(to_point(x));
+        }
+    }
+
+private:
+    std::array<uint32_t, Dim> integer_point(uint64_t index) const
+    {
+        std::array<uint32_t, Dim> x = shift_;
+
+        uint64_t gray = index ^ (index >> 1);
+        for (unsigned k = 0; gray != 0; ++k, gray >>= 1)
+            if (gray & 1)
+                for (size_t d = 0; d < Dim; ++d)
+                    x[d] ^= directions_[d][k];
+
+        return x;
+    }
+
+    static std::array<double, Dim> to_point(const std::array<uint32_t, Dim>& x)
+    {
+        std::array<double, Dim> point;
+        for (size_t d = 0; d < Dim; ++d)
+            point[d] = x[d] * 0x1.0p-32;
+
+        return point;
+    }
+};
+
+// Halton sequence (radical inverse in the first Dim prime bases).
+// Randomized with a Cranley-Patterson rotation: (x + u) mod 1.
+template <size_t Dim>
+class HaltonSequence
+{
+    static constexpr std::array<uint32_t, 8> primes = {2, 3, 5, 7, 11, 13, 17, 19};
+
+    static_assert(Dim >= 1 && Dim <= primes.size(), "HaltonSequence: unsupported number of dimensions");
+
+    std::array<double, Dim> shift_{};
+
+    static double radical_inverse(uint64_t index, uint32_t base)
+    {
+        const double inv_base = 1.0 / base;
+        double inv_base_n = inv_base;
+        double result = 0.0;
+
+        while (index > 0)
+        {
+            result += static_cast<double>(index % base) * inv_base_n;
+            index /= base;
+            inv_base_n *= inv_base;
+        }
+
+        return result;
+    }
+
+public:
+    static constexpr size_t dimensions = Dim;
+
+    explicit HaltonSequence(uint64_t seed = 0)
+    {
+        if (seed != 0)
+        {
+            Xoshiro256StarStar rnd_gen{seed};
+            for (auto& u : shift_)
+                u = uniform_double(rnd_gen);
+        }
+    }
+
+    std::array<double, Dim> operator[](uint64_t index) const
+    {
+        std::array<double, Dim> point;
+        for (size_t d = 0; d < Dim; ++d)
+        {
+            const double x = radical_inverse(index, primes[d]) + shift_[d];
+            point[d] = (x < 1.0) ? x : x - 1.0;
+        }
+
+        return point;
+    }
+
+    template <typename F>
+    void for_each_point(uint64_t first, uint64_t count, F f) const
+    {
+        for (uint64_t i = first; i < first + count; ++i)
+            f((*this)[i]);
+    }
+};
+
+template <typename Sequence>
+uintmax_t count_hits_qmc(const Sequence& sequence, uint64_t first, uint64_t count)
+{
+    static_assert(Sequence::dimensions == 2);
+
+    uintmax_t hits = 0;
+    sequence.for_each_point(first, count, [&hits](const std::array<double, 2>& point) {
+        hits += (point[0] * point[0] + point[1] * point[1] < 1.0);
+    });
+
+    return hits;
+}
+
+#endif
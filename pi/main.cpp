@@ -1,138 +1,539 @@
+#include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdlib>
+#include <iomanip>
 #include <iostream>
+#include <numbers>
+#include <numeric>
+#include <optional>
 #include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
 #include <thread>
-#include <cstdlib>
-#include <ctime>
-#include <numeric>
+#include <vector>
+
+#include "calc_hits.hpp"
+#include "checkpoint.hpp"
+#include "chudnovsky.hpp"
+#include "convergence.hpp"
+#include "low_discrepancy.hpp"
+#include "monte_carlo.hpp"
+#include "multi_process.hpp"
+#include "per_thread.hpp"
+#include "topology.hpp"
 
 using namespace std;
 
-void calc_hits(const uintmax_t count, uintmax_t& hits)
+// "checkpointed" writes a file, so it only runs when asked for by name
+const vector<string> other_strategies = {"checkpointed"};
+const vector<string> all_strategies = {"single", "partial-array", "atomic", "padded", "work-stealing", "simd", "transform-reduce", "integrate", "sobol", "multi-process"};
+
+struct Options
+{
+    string engine = "monte-carlo";
+    size_t digits = 1'000'000; // chudnovsky only
+    uintmax_t samples = 100'000'000;
+    size_t threads = max(1u, thread::hardware_concurrency());
+    size_t processes = 0; // multi-process only - 0 means one per thread
+    vector<string> strategies = all_strategies;
+    string rng = "xoshiro256**";
+    size_t repetitions = 1;
+    uint64_t seed = default_seed;
+    optional<double> tolerance; // sobol only - stop early once the error bound is reached
+    string checkpoint = "pi.checkpoint";
+    double checkpoint_interval = 10.0; // seconds
+    string format = "text";
+    Placement placement = Placement::none;
+    vector<unsigned> cpus; // worker i runs on cpus[i] - filled from the topology, empty for Placement::none
+};
+
+struct Estimate
 {
-    std::mt19937_64 rnd_gen(std::hash<std::thread::id>{}(std::this_thread::get_id()));
-    std::uniform_real_distribution<double> rnd(0, 1.0);
+    double pi;
+    uintmax_t samples;
+};
 
-    uintmax_t local_hits = 0;
-    for (uintmax_t n = 0; n < count; ++n)
-    {
-        double x = rnd(rnd_gen);
-        double y = rnd(rnd_gen);
+void print_usage(ostream& out)
+{
+    out << "Usage: pi_tests [options]\n"
+        << "  --engine E         monte-carlo (default) or chudnovsky\n"
+        << "  --digits D         chudnovsky: decimal digits of pi (default 1000000)\n"
+        << "  --samples N        number of samples (default 100000000)\n"
+        << "  --threads T        number of worker threads (default hardware_concurrency)\n"
+        << "  --strategy S[,S]   single, partial-array, atomic, padded, work-stealing, simd,\n"
+        << "                     transform-reduce, integrate, sobol, multi-process, all, checkpointed\n"
+        << "  --processes K      multi-process: number of forked workers (default = threads)\n"
+        << "  --rng R            xoshiro256** (default) or mt19937_64\n"
+        << "  --repetitions R    timed runs per strategy (default 1)\n"
+        << "  --seed S           base seed (default " << default_seed << ")\n"
+        << "  --tolerance E      sobol: stop once 3 * std error <= E (samples is the upper limit)\n"
+        << "  --placement P      none (default), compact or spread - pin workers to cores / NUMA nodes\n"
+        << "  --checkpoint FILE  checkpointed: progress file, resumed if it exists (default pi.checkpoint)\n"
+        << "  --checkpoint-interval S  checkpointed: seconds between saves (default 10)\n"
+        << "  --format F         text (default), json or csv\n";
+}
+
+vector<string> split(const string& text, char separator)
+{
+    vector<string> items;
+    stringstream ss{text};
+    for (string item; getline(ss, item, separator);)
+        if (!item.empty())
+            items.push_back(item);
+    return items;
+}
 
-        if (x * x + y * y < 1)
-            local_hits++;
+Options parse_options(int argc, char* argv[])
+{
+    Options opts;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const string arg = argv[i];
+
+        if (arg == "--help" || arg == "-h")
+        {
+            print_usage(cout);
+            exit(0);
+        }
+
+        if (i + 1 >= argc)
+            throw invalid_argument("missing value for " + arg);
+
+        const string value = argv[++i];
+
+        if (arg == "--engine")
+            opts.engine = value;
+        else if (arg == "--digits")
+            opts.digits = max<size_t>(stoull(value), 1);
+        else if (arg == "--samples")
+            opts.samples = stoull(value);
+        else if (arg == "--threads")
+            opts.threads = max<size_t>(stoul(value), 1);
+        else if (arg == "--processes")
+            opts.processes = max<size_t>(stoul(value), 1);
+        else if (arg == "--strategy")
+            opts.strategies = (value == "all") ? all_strategies : split(value, ',');
+        else if (arg == "--rng")
+            opts.rng = value;
+        else if (arg == "--repetitions")
+            opts.repetitions = max<size_t>(stoul(value), 1);
+        else if (arg == "--seed")
+            opts.seed = stoull(value);
+        else if (arg == "--tolerance")
+            opts.tolerance = stod(value);
+        else if (arg == "--checkpoint")
+            opts.checkpoint = value;
+        else if (arg == "--checkpoint-interval")
+            opts.checkpoint_interval = stod(value);
+        else if (arg == "--format")
+            opts.format = value;
+        else if (arg == "--placement")
+            opts.placement = placement_from_string(value);
+        else
+            throw invalid_argument("unknown option " + arg);
     }
 
-    hits += local_hits;
+    if (opts.engine != "monte-carlo" && opts.engine != "chudnovsky")
+        throw invalid_argument("unknown engine " + opts.engine);
+
+    for (const auto& strategy : opts.strategies)
+        if (find(all_strategies.begin(), all_strategies.end(), strategy) == all_strategies.end()
+            && find(other_strategies.begin(), other_strategies.end(), strategy) == other_strategies.end())
+            throw invalid_argument("unknown strategy " + strategy);
+
+    if (opts.rng != "xoshiro256**" && opts.rng != "mt19937_64")
+        throw invalid_argument("unknown rng " + opts.rng);
+
+    if (opts.format != "text" && opts.format != "json" && opts.format != "csv")
+        throw invalid_argument("unknown format " + opts.format);
+
+    if (opts.processes == 0)
+        opts.processes = opts.threads;
+
+    opts.cpus = assign_cpus(CpuTopology::detect().restricted_to(current_affinity()), opts.placement, opts.threads);
+
+    return opts;
 }
 
-void calc_hits(const uintmax_t count, std::atomic<uintmax_t>& hits)
+//////////////////////////////////////////////////////////////////////////////
+// strategies
+
+// thread i gets samples [N * i / T, N * (i + 1) / T) - no remainder is dropped
+uintmax_t slice(uintmax_t N, size_t i, size_t no_of_threads)
 {
-    std::mt19937_64 rnd_gen(std::hash<std::thread::id>{}(std::this_thread::get_id()));
-    std::uniform_real_distribution<double> rnd(0, 1.0);
+    return N * (i + 1) / no_of_threads - N * i / no_of_threads;
+}
 
-    uintmax_t local_hits = 0;
-    for (uintmax_t n = 0; n < count; ++n)
-    {
-        double x = rnd(rnd_gen);
-        double y = rnd(rnd_gen);
+template <typename RndGen>
+uintmax_t partial_array(const Options& opts)
+{
+    const auto streams = make_generators<RndGen>(opts.seed, opts.threads);
 
-        if (x * x + y * y < 1)
-            local_hits++;
-    }
+    std::vector<std::thread> thds;
+    std::vector<uintmax_t> partial_hits(opts.threads);
+
+    for (size_t i = 0; i < opts.threads; ++i)
+        thds.push_back(std::thread([&, i] {
+            const ScopedPin pin{opts.cpus, i};
+            calc_hits(slice(opts.samples, i, opts.threads), partial_hits[i], streams[i]);
+        }));
 
-    hits += local_hits;
+    for (auto& thd : thds)
+        thd.join();
+
+    return std::accumulate(partial_hits.begin(), partial_hits.end(), uintmax_t{0});
 }
 
-int main()
+template <typename RndGen>
+uintmax_t shared_atomic(const Options& opts)
 {
-    const uintmax_t N = 100'000'000;
+    const auto streams = make_generators<RndGen>(opts.seed, opts.threads);
 
-    {
-        //////////////////////////////////////////////////////////////////////////////
-        // single thread
+    std::vector<std::thread> thds;
+    std::atomic<uintmax_t> hits = 0;
 
-        cout << "Pi calculation started!" << endl;
-        const auto start = chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < opts.threads; ++i)
+        thds.push_back(std::thread([&, i] {
+            const ScopedPin pin{opts.cpus, i};
+            calc_hits(slice(opts.samples, i, opts.threads), hits, streams[i]);
+        }));
 
-        uintmax_t hits = 0;
+    for (auto& thd : thds)
+        thd.join();
 
-        calc_hits(N, hits);
+    return hits;
+}
 
-        const double pi = static_cast<double>(hits) / N * 4;
+template <typename RndGen>
+uintmax_t padded(const Options& opts)
+{
+    const auto streams = make_generators<RndGen>(opts.seed, opts.threads);
 
-        const auto end = chrono::high_resolution_clock::now();
-        const auto elapsed_time = chrono::duration_cast<chrono::milliseconds>(end - start).count();
+    std::vector<std::thread> thds;
+    PerThread<uintmax_t> hits(opts.threads);
 
-        cout << "Pi = " << pi << endl;
-        cout << "Elapsed = " << elapsed_time << "ms" << endl;
+    for (size_t i = 0; i < opts.threads; ++i)
+        thds.push_back(std::thread([&, i] {
+            const ScopedPin pin{opts.cpus, i};
+            calc_hits(slice(opts.samples, i, opts.threads), hits.local(i), streams[i]);
+        }));
 
-        //////////////////////////////////////////////////////////////////////////////
-    }
+    for (auto& thd : thds)
+        thd.join();
+
+    return hits.combine();
+}
+
+uintmax_t sobol_hits(const Options& opts)
+{
+    if (opts.samples > SobolSequence<2>::max_points)
+        throw invalid_argument("sobol: at most " + to_string(SobolSequence<2>::max_points) + " samples (2^32 points)");
+
+    const SobolSequence<2> sobol{opts.seed};
+    PerThread<uintmax_t> hits(opts.threads);
 
+    run_work_stealing(opts.samples, 1 << 16, opts.threads, [&](size_t id, const SampleBlock& block) {
+        hits.local(id) += count_hits_qmc(sobol, block.first, block.count);
+    }, opts.cpus);
+
+    return hits.combine();
+}
+
+// set by SIGINT/SIGTERM (preemption) - the checkpointed strategy saves its progress and exits
+atomic<bool> stop_requested = false;
+
+void request_stop(int)
+{
+    stop_requested = true;
+}
+
+uintmax_t checkpointed_hits(const Options& opts)
+{
+    signal(SIGINT, request_stop);
+    signal(SIGTERM, request_stop);
+
+    const auto interval = chrono::duration_cast<chrono::milliseconds>(chrono::duration<double>(opts.checkpoint_interval));
+    const optional<uintmax_t> hits = calc_hits_checkpointed(opts.samples, opts.threads, opts.seed, opts.checkpoint, interval, &stop_requested);
+
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+
+    if (!hits)
     {
-        //////////////////////////////////////////////////////////////////////////////
-        // single thread
+        cerr << "interrupted - progress saved to " << opts.checkpoint << ", run again with the same options to resume\n";
+        exit(2);
+    }
 
-        cout << "Pi calculation started!" << endl;
-        const auto start = chrono::high_resolution_clock::now();
+    return *hits;
+}
 
-        uintmax_t hits = 0;
+template <typename RndGen>
+Estimate run_strategy(const string& strategy, const Options& opts)
+{
+    const uintmax_t N = opts.samples;
+    auto from_hits = [N](uintmax_t hits) { return Estimate{static_cast<double>(hits) / N * 4, N}; };
 
-        size_t no_of_cores = std::thread::hardware_concurrency();
-        size_t N_per_thread = N / no_of_cores;
+    if (strategy == "single")
+    {
+        uintmax_t hits = 0;
+        calc_hits(N, hits, RndGen{opts.seed});
+        return from_hits(hits);
+    }
+    if (strategy == "partial-array")
+        return from_hits(partial_array<RndGen>(opts));
+    if (strategy == "atomic")
+        return from_hits(shared_atomic<RndGen>(opts));
+    if (strategy == "padded")
+        return from_hits(padded<RndGen>(opts));
+    if (strategy == "work-stealing")
+        return from_hits(calc_hits_work_stealing<RndGen>(N, opts.threads, opts.seed, 1 << 16, opts.cpus));
+    if (strategy == "simd")
+        return from_hits(calc_hits_simd(N, opts.threads, opts.seed, 1 << 20, opts.cpus));
+    if (strategy == "transform-reduce")
+        return from_hits(calc_hits_transform_reduce(N, opts.seed));
+    if (strategy == "integrate")
+    {
+        auto in_circle = [](const std::array<double, 2>& p) { return (p[0] * p[0] + p[1] * p[1] < 1.0) ? 1.0 : 0.0; };
+        const IntegrationResult result = monte_carlo_integrate<2>(in_circle, Box<2>{{-1.0, -1.0}, {1.0, 1.0}}, N,
+            WorkStealing{opts.threads, opts.cpus}, opts.seed);
+        return Estimate{result.estimate, result.samples};
+    }
+    if (strategy == "sobol")
+    {
+        if (opts.tolerance)
+        {
+            const ConvergenceResult result = estimate_pi_until(*opts.tolerance, SampleSource::sobol, opts.seed, N, 16, opts.threads);
+            return Estimate{result.pi, result.samples};
+        }
+        return from_hits(sobol_hits(opts));
+    }
+    if (strategy == "checkpointed")
+        return from_hits(checkpointed_hits(opts));
+    if (strategy == "multi-process")
+    {
+        const MultiProcessResult result = calc_hits_multi_process(N, opts.processes, opts.seed);
+        if (result.restarts > 0)
+            cerr << "multi-process: " << result.restarts << " crashed worker(s) restarted\n";
+        return from_hits(result.hits);
+    }
 
-        std::vector<std::thread> thds;
-        std::vector<uintmax_t> partial_hits(no_of_cores);
+    throw invalid_argument("unknown strategy " + strategy);
+}
 
-        for (size_t i = 0; i < no_of_cores; ++i)
-            thds.push_back(std::thread([&, i, N_per_thread] { calc_hits(N_per_thread, partial_hits[i]); }));
+Estimate run_strategy(const string& strategy, const Options& opts)
+{
+    if (opts.rng == "mt19937_64")
+        return run_strategy<std::mt19937_64>(strategy, opts);
+    return run_strategy<Xoshiro256StarStar>(strategy, opts);
+}
 
-        for (auto& thd : thds)
-            thd.join();
+//////////////////////////////////////////////////////////////////////////////
+// measurements
 
-        hits = std::accumulate(partial_hits.begin(), partial_hits.end(), 0ULL);
+struct Report
+{
+    string strategy;
+    size_t threads;
+    Estimate estimate;
+    vector<double> seconds; // one per repetition
 
-        const double pi = static_cast<double>(hits) / N * 4;
+    double median() const
+    {
+        vector<double> sorted = seconds;
+        sort(sorted.begin(), sorted.end());
+        const size_t n = sorted.size();
+        return (n % 2) ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2;
+    }
 
-        const auto end = chrono::high_resolution_clock::now();
-        const auto elapsed_time = chrono::duration_cast<chrono::milliseconds>(end - start).count();
+    double min() const { return *min_element(seconds.begin(), seconds.end()); }
+    double max() const { return *max_element(seconds.begin(), seconds.end()); }
+    double samples_per_second() const { return estimate.samples / median(); }
+};
 
-        cout << "Pi = " << pi << endl;
-        cout << "Elapsed = " << elapsed_time << "ms" << endl;
+Report measure(const string& strategy, const Options& opts)
+{
+    // the parallel algorithms pick their own number of threads
+    const size_t threads = (strategy == "single") ? 1
+        : (strategy == "transform-reduce") ? max(1u, thread::hardware_concurrency())
+        : (strategy == "multi-process") ? opts.processes
+        : opts.threads;
+    Report report{strategy, threads, {}, {}};
+
+    for (size_t r = 0; r < opts.repetitions; ++r)
+    {
+        const auto start = chrono::steady_clock::now();
+        report.estimate = run_strategy(strategy, opts);
+        const auto end = chrono::steady_clock::now();
 
-        //////////////////////////////////////////////////////////////////////////////
+        report.seconds.push_back(chrono::duration<double>(end - start).count());
     }
 
+    return report;
+}
+
+// samples/s per thread relative to the single-threaded run
+double parallel_efficiency(const Report& report, const Report& baseline)
+{
+    return report.samples_per_second() / (report.threads * baseline.samples_per_second());
+}
+
+void print_text(const Options& opts, const vector<Report>& reports, const Report& baseline)
+{
+    cout << "samples: " << opts.samples << ", threads: " << opts.threads << ", rng: " << opts.rng
+         << ", repetitions: " << opts.repetitions << ", simd: " << to_string(best_simd_path())
+         << ", placement: " << to_string(opts.placement) << "\n";
+
+    for (const auto& r : reports)
     {
-        //////////////////////////////////////////////////////////////////////////////
-        // single thread
+        cout << left << setw(17) << r.strategy << right
+             << " Pi = " << fixed << setprecision(8) << r.estimate.pi
+             << " (error " << scientific << setprecision(2) << abs(r.estimate.pi - numbers::pi) << ")"
+             << fixed << setprecision(1)
+             << "  median = " << r.median() * 1000 << "ms"
+             << " [" << r.min() * 1000 << ", " << r.max() * 1000 << "]"
+             << "  " << r.samples_per_second() / 1e6 << " Msamples/s"
+             << "  efficiency = " << setprecision(2) << parallel_efficiency(r, baseline) << "\n";
+    }
+}
+
+void print_csv(const Options& opts, const vector<Report>& reports, const Report& baseline)
+{
+    cout << "strategy,rng,placement,threads,samples,repetitions,pi,abs_error,median_s,min_s,max_s,samples_per_s,parallel_efficiency\n";
 
-        cout << "Pi calculation started!" << endl;
-        const auto start = chrono::high_resolution_clock::now();
+    for (const auto& r : reports)
+        cout << setprecision(10) << r.strategy << ',' << opts.rng << ',' << to_string(opts.placement) << ',' << r.threads << ',' << r.estimate.samples << ','
+             << opts.repetitions << ',' << r.estimate.pi << ',' << abs(r.estimate.pi - numbers::pi) << ','
+             << r.median() << ',' << r.min() << ',' << r.max() << ',' << r.samples_per_second() << ','
+             << parallel_efficiency(r, baseline) << '\n';
+}
 
-        std::atomic<uintmax_t> hits = 0;
+void print_json(const Options& opts, const vector<Report>& reports, const Report& baseline)
+{
+    cout << setprecision(10) << "{\n"
+         << "  \"samples\": " << opts.samples << ",\n"
+         << "  \"threads\": " << opts.threads << ",\n"
+         << "  \"rng\": \"" << opts.rng << "\",\n"
+         << "  \"seed\": " << opts.seed << ",\n"
+         << "  \"repetitions\": " << opts.repetitions << ",\n"
+         << "  \"simd\": \"" << to_string(best_simd_path()) << "\",\n"
+         << "  \"placement\": \"" << to_string(opts.placement) << "\",\n"
+         << "  \"hardware_concurrency\": " << thread::hardware_concurrency() << ",\n"
+         << "  \"results\": [\n";
+
+    for (size_t i = 0; i < reports.size(); ++i)
+    {
+        const Report& r = reports[i];
+        cout << "    {\"strategy\": \"" << r.strategy << "\", \"threads\": " << r.threads
+             << ", \"samples\": " << r.estimate.samples << ", \"pi\": " << r.estimate.pi
+             << ", \"abs_error\": " << abs(r.estimate.pi - numbers::pi)
+             << ", \"median_s\": " << r.median() << ", \"min_s\": " << r.min() << ", \"max_s\": " << r.max()
+             << ", \"samples_per_s\": " << r.samples_per_second()
+             << ", \"parallel_efficiency\": " << parallel_efficiency(r, baseline) << "}"
+             << (i + 1 < reports.size() ? "," : "") << "\n";
+    }
 
-        size_t no_of_cores = std::thread::hardware_concurrency();
-        size_t N_per_thread = N / no_of_cores;
+    cout << "  ]\n}\n";
+}
 
-        std::vector<std::thread> thds;
+//////////////////////////////////////////////////////////////////////////////
+// chudnovsky engine - exact digits instead of an estimate
 
-        for (size_t i = 0; i < no_of_cores; ++i)
-            thds.push_back(std::thread([&, i, N_per_thread] { calc_hits(N_per_thread, hits); }));
+void run_chudnovsky(const Options& opts)
+{
+    string pi;
+    vector<double> seconds;
 
-        for (auto& thd : thds)
-            thd.join();        
+    for (size_t r = 0; r < opts.repetitions; ++r)
+    {
+        const auto start = chrono::steady_clock::now();
+        pi = chudnovsky_pi(opts.digits, opts.threads);
+        const auto end = chrono::steady_clock::now();
 
-        const double pi = static_cast<double>(hits) / N * 4;
+        seconds.push_back(chrono::duration<double>(end - start).count());
+    }
 
-        const auto end = chrono::high_resolution_clock::now();
-        const auto elapsed_time = chrono::duration_cast<chrono::milliseconds>(end - start).count();
+    Report report{"chudnovsky", opts.threads, {}, seconds};
+    const bool verified = verify_pi_digits(pi);
+    const double digits_per_second = opts.digits / report.median();
+    const string tail = pi.substr(pi.size() - min<size_t>(opts.digits, 10));
+
+    if (opts.format == "json")
+        cout << setprecision(10) << "{\n"
+             << "  \"engine\": \"chudnovsky\",\n"
+             << "  \"digits\": " << opts.digits << ",\n"
+             << "  \"threads\": " << opts.threads << ",\n"
+             << "  \"repetitions\": " << opts.repetitions << ",\n"
+             << "  \"median_s\": " << report.median() << ", \"min_s\": " << report.min() << ", \"max_s\": " << report.max() << ",\n"
+             << "  \"digits_per_s\": " << digits_per_second << ",\n"
+             << "  \"last_digits\": \"" << tail << "\",\n"
+             << "  \"verified\": " << boolalpha << verified << "\n"
+             << "}\n";
+    else if (opts.format == "csv")
+        cout << "engine,digits,threads,repetitions,median_s,min_s,max_s,digits_per_s,last_digits,verified\n"
+             << setprecision(10) << "chudnovsky," << opts.digits << ',' << opts.threads << ',' << opts.repetitions << ','
+             << report.median() << ',' << report.min() << ',' << report.max() << ',' << digits_per_second << ','
+             << tail << ',' << boolalpha << verified << '\n';
+    else
+        cout << "chudnovsky: " << opts.digits << " digits, threads: " << opts.threads
+             << ", repetitions: " << opts.repetitions << "\n"
+             << "Pi = " << pi.substr(0, 52) << (opts.digits > 50 ? "..." + tail : "") << "\n"
+             << fixed << setprecision(1)
+             << "median = " << report.median() * 1000 << "ms"
+             << " [" << report.min() * 1000 << ", " << report.max() * 1000 << "]"
+             << "  " << setprecision(0) << digits_per_second << " digits/s"
+             << "  verified = " << (verified ? "yes" : "NO") << "\n";
+}
 
-        cout << "Pi = " << pi << endl;
-        cout << "Elapsed = " << elapsed_time << "ms" << endl;
+int main(int argc, char* argv[])
+{
+    Options opts;
+    try
+    {
+        opts = parse_options(argc, argv);
+    }
+    catch (const exception& e)
+    {
+        cerr << "Error: " << e.what() << "\n";
+        print_usage(cerr);
+        return 1;
+    }
 
-        //////////////////////////////////////////////////////////////////////////////
+    // runtime failures (an unwritable checkpoint, a multi-process worker that keeps crashing, out of memory, ...)
+    // end the program the same way as bad options, without a core dump
+    try
+    {
+        if (opts.engine == "chudnovsky")
+        {
+            run_chudnovsky(opts);
+            return 0;
+        }
+
+        vector<Report> reports;
+        for (const auto& strategy : opts.strategies)
+            reports.push_back(measure(strategy, opts));
+
+        // efficiency is relative to the single-threaded strategy - measured separately if it was not requested
+        auto single = find_if(reports.begin(), reports.end(), [](const Report& r) { return r.strategy == "single"; });
+        const Report baseline = (single != reports.end()) ? *single : measure("single", opts);
+
+        if (opts.format == "json")
+            print_json(opts, reports, baseline);
+        else if (opts.format == "csv")
+            print_csv(opts, reports, baseline);
+        else
+            print_text(opts, reports, baseline);
+
+        if (const size_t failures = ScopedPin::no_of_failures(); failures > 0)
+            cerr << "placement: " << failures << " thread(s) could not be pinned and ran unpinned\n";
     }
-}
\ No newline at end of file
+    catch (const exception& e)
+    {
+        cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+}
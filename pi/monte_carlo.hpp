@@ -0,0 +1,191 @@
+#ifndef MONTE_CARLO_HPP
+#define MONTE_CARLO_HPP
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "calc_hits.hpp"
+#include "rng.hpp"
+#include "work_stealing.hpp"
+
+template <size_t Dim>
+struct Box
+{
+    std::array<double, Dim> lower;
+    std::array<double, Dim> upper;
+
+    double volume() const
+    {
+        double v = 1.0;
+        for (size_t d = 0; d < Dim; ++d)
+            v *= upper[d] - lower[d];
+        return v;
+    }
+};
+
+template <size_t Dim>
+Box<Dim> unit_box()
+{
+    Box<Dim> box;
+    box.lower.fill(0.0);
+    box.upper.fill(1.0);
+    return box;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// execution policies - the same threading backends as pi/main.cpp
+// policy(no_of_blocks, block_func) must call block_func(block_index) exactly once for every block
+
+struct Sequential
+{
+    template <typename BlockFunc>
+    void operator()(uintmax_t no_of_blocks, BlockFunc block_func) const
+    {
+        for (uintmax_t b = 0; b < no_of_blocks; ++b)
+            block_func(b);
+    }
+};
+
+// one std::thread per contiguous range of blocks
+struct StaticPartition
+{
+    size_t no_of_threads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<unsigned> cpus = {}; // optional placement - see assign_cpus
+
+    template <typename BlockFunc>
+    void operator()(uintmax_t no_of_blocks, BlockFunc block_func) const
+    {
+        const size_t n = std::max<size_t>(no_of_threads, 1);
+
+        std::vector<std::thread> thds;
+        for (size_t i = 0; i < n; ++i)
+            thds.emplace_back([=, this, &block_func] {
+                const ScopedPin pin{cpus, i};
+                for (uintmax_t b = no_of_blocks * i / n; b < no_of_blocks * (i + 1) / n; ++b)
+                    block_func(b);
+            });
+
+        for (auto& thd : thds)
+            thd.join();
+    }
+};
+
+struct WorkStealing
+{
+    size_t no_of_threads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<unsigned> cpus = {};
+
+    template <typename BlockFunc>
+    void operator()(uintmax_t no_of_blocks, BlockFunc block_func) const
+    {
+        run_work_stealing(no_of_blocks, 1, no_of_threads, [&block_func](size_t, const SampleBlock& block) {
+            block_func(block.first);
+        }, cpus);
+    }
+};
+
+//////////////////////////////////////////////////////////////////////////////
+
+// count, mean and sum of squared deviations - merged pairwise (Chan et al.)
+struct Moments
+{
+    uintmax_t n = 0;
+    double mean = 0.0;
+    double m2 = 0.0;
+
+    void merge(const Moments& other)
+    {
+        if (other.n == 0)
+            return;
+
+        const uintmax_t total = n + other.n;
+        const double delta = other.mean - mean;
+        mean += delta * other.n / total;
+        m2 += other.m2 + delta * delta * (static_cast<double>(n) * other.n / total);
+        n = total;
+    }
+
+    double variance() const
+    {
+        return (n > 1) ? m2 / (n - 1) : 0.0;
+    }
+};
+
+struct IntegrationResult
+{
+    double estimate;
+    double variance; // of the estimate
+    double std_error;
+    uintmax_t samples;
+    double seconds;
+    double samples_per_second;
+};
+
+// Estimates the integral of f over domain with `samples` uniform points.
+// f is called as f(const std::array<double, Dim>&) and is a template parameter, so it is inlined into the sampling loop.
+// Samples are drawn in blocks, each from its own jump() stream, and block results are merged in block order -
+// the result is identical for every policy and thread count.
+template <size_t Dim, typename Integrand, typename Policy = Sequential>
+IntegrationResult monte_carlo_integrate(Integrand f, const Box<Dim>& domain, uintmax_t samples, Policy policy = {},
+    uint64_t seed = default_seed, uintmax_t block_size = 1 << 16)
+{
+    static_assert(Dim > 0);
+
+    block_size = std::max<uintmax_t>(block_size, 1);
+    const uintmax_t no_of_blocks = (samples + block_size - 1) / block_size;
+
+    const auto start = std::chrono::steady_clock::now();
+
+    const std::vector<Xoshiro256StarStar> block_streams = make_streams(seed, no_of_blocks);
+    std::vector<Moments> block_moments(no_of_blocks);
+
+    std::array<double, Dim> width;
+    for (size_t d = 0; d < Dim; ++d)
+        width[d] = domain.upper[d] - domain.lower[d];
+
+    policy(no_of_blocks, [&](uintmax_t b) {
+        Xoshiro256StarStar rnd_gen = block_streams[b];
+        const uintmax_t count = std::min(block_size, samples - b * block_size);
+
+        // plain sums in the hot loop (no division per sample); shifting by the first value keeps
+        // sum_sq - sum^2 / n well conditioned when the mean is large compared to the spread
+        double shift = 0.0;
+        double sum = 0.0;
+        double sum_sq = 0.0;
+        std::array<double, Dim> x;
+        for (uintmax_t n = 0; n < count; ++n)
+        {
+            for (size_t d = 0; d < Dim; ++d)
+                x[d] = domain.lower[d] + width[d] * uniform_double(rnd_gen);
+
+            const double value = f(x);
+            if (n == 0)
+                shift = value;
+
+            sum += value - shift;
+            sum_sq += (value - shift) * (value - shift);
+        }
+
+        if (count > 0)
+            block_moments[b] = Moments{count, shift + sum / count, std::max(0.0, sum_sq - sum * sum / count)};
+    });
+
+    Moments total;
+    for (const auto& m : block_moments)
+        total.merge(m);
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const double volume = domain.volume();
+    const double variance = (total.n > 0) ? volume * volume * total.variance() / total.n : 0.0;
+
+    return {volume * total.mean, variance, std::sqrt(variance), total.n, seconds,
+        (seconds > 0) ? total.n / seconds : 0.0};
+}
+
+#endif
@@ -0,0 +1,217 @@
+#include "multi_process.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "per_thread.hpp"
+#include "rng.hpp"
+
+namespace
+{
+    struct alignas(cache_line_size) ChunkResult
+    {
+        std::atomic<uint64_t> hits;
+        std::atomic<uint32_t> done;
+    };
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "counters must be usable across processes");
+
+#ifdef __linux__
+    // anonymous POSIX shm segment - unlinked right after mapping, so nothing is left behind if we crash;
+    // the mapping is inherited by the forked workers
+    class SharedResults
+    {
+        ChunkResult* results_ = nullptr;
+        size_t bytes_ = 0;
+
+    public:
+        explicit SharedResults(size_t no_of_chunks)
+            : bytes_{no_of_chunks * sizeof(ChunkResult)}
+        {
+            static std::atomic<unsigned> counter = 0;
+            const std::string name = "/pi_hits_" + std::to_string(getpid()) + "_" + std::to_string(counter++);
+
+            const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+            if (fd == -1)
+                throw std::runtime_error("shm_open failed for " + name);
+
+            void* memory = MAP_FAILED;
+            if (ftruncate(fd, static_cast<off_t>(bytes_)) == 0)
+                memory = mmap(nullptr, bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+            close(fd);
+            shm_unlink(name.c_str());
+
+            if (memory == MAP_FAILED)
+                throw std::runtime_error("cannot map shared memory segment " + name);
+
+            results_ = static_cast<ChunkResult*>(memory);
+            for (size_t i = 0; i < no_of_chunks; ++i)
+                new (&results_[i]) ChunkResult{{0}, {0}};
+        }
+
+        ~SharedResults()
+        {
+            munmap(results_, bytes_);
+        }
+
+        SharedResults(const SharedResults&) = delete;
+        SharedResults& operator=(const SharedResults&) = delete;
+
+        ChunkResult& operator[](size_t chunk)
+        {
+            return results_[chunk];
+        }
+    };
+
+    // The forked child. The parent may have other threads (a TBB pool, worker threads of earlier strategies) whose
+    // locks were copied in whatever state they were in, so the child only does what is async-signal-safe:
+    // arithmetic on its own stack, lock-free atomics in the shared segment, and _exit, which skips the parent's
+    // destructors and atexit handlers. Nothing allocates; an exception ends the child through std::terminate
+    // (noexcept) instead of unwinding into the parent's code - the parent restarts the chunk.
+    [[noreturn]] void run_worker(const std::function<void(size_t, size_t)>& worker_hook, size_t chunk, size_t attempt,
+        uintmax_t samples, Xoshiro256StarStar rnd_gen, ChunkResult& result) noexcept
+    {
+        if (worker_hook)
+            worker_hook(chunk, attempt);
+
+        uintmax_t hits = 0;
+        calc_hits(samples, hits, rnd_gen);
+
+        result.hits.store(hits, std::memory_order_relaxed);
+        result.done.store(1, std::memory_order_release);
+        _exit(0);
+    }
+
+    pid_t wait_for(pid_t pid, int& status)
+    {
+        pid_t result;
+        do
+            result = waitpid(pid, &status, 0);
+        while (result == -1 && errno == EINTR);
+        return result;
+    }
+
+    // the forked workers still running - killed and reaped if the parent leaves early (an exception)
+    class Workers
+    {
+        std::map<pid_t, size_t> running_; // pid -> chunk
+
+    public:
+        Workers() = default;
+        Workers(const Workers&) = delete;
+        Workers& operator=(const Workers&) = delete;
+
+        ~Workers()
+        {
+            for (const auto& [pid, _] : running_)
+                kill(pid, SIGKILL);
+            int status = 0;
+            for (const auto& [pid, _] : running_)
+                wait_for(pid, status);
+        }
+
+        bool empty() const { return running_.empty(); }
+
+        void add(pid_t pid, size_t chunk) { running_[pid] = chunk; }
+
+        // reaps the next worker to finish - children of the process that are not workers are left to their owner
+        // (a foreign zombie makes it wait for one particular worker instead); {pid, chunk}, pid -1 on error
+        std::pair<pid_t, size_t> wait(int& status)
+        {
+            siginfo_t info{};
+            int result;
+            do
+                result = waitid(P_ALL, 0, &info, WEXITED | WNOWAIT);
+            while (result == -1 && errno == EINTR);
+            if (result == -1)
+                return {-1, 0};
+
+            const auto next = running_.contains(info.si_pid) ? running_.find(info.si_pid) : running_.begin();
+            const auto [pid, chunk] = *next;
+            if (wait_for(pid, status) == -1)
+                return {-1, 0};
+
+            running_.erase(pid);
+            return {pid, chunk};
+        }
+    };
+#endif
+}
+
+MultiProcessResult calc_hits_multi_process(uintmax_t count, size_t no_of_processes, uint64_t seed,
+    size_t max_attempts, const std::function<void(size_t, size_t)>& worker_hook)
+{
+#ifdef __linux__
+    const size_t no_of_chunks = std::max<size_t>(no_of_processes, 1);
+    max_attempts = std::max<size_t>(max_attempts, 1);
+
+    const std::vector<Xoshiro256StarStar> streams = make_streams(seed, no_of_chunks);
+    SharedResults results(no_of_chunks);
+
+    Workers running;
+    std::vector<size_t> attempts(no_of_chunks, 0);
+    size_t restarts = 0;
+
+    auto start_worker = [&](size_t chunk) {
+        const size_t attempt = attempts[chunk]++;
+
+        const pid_t pid = fork();
+        if (pid == -1)
+            throw std::runtime_error("fork failed");
+
+        if (pid == 0)
+            run_worker(worker_hook, chunk, attempt, count * (chunk + 1) / no_of_chunks - count * chunk / no_of_chunks,
+                streams[chunk], results[chunk]);
+
+        running.add(pid, chunk);
+    };
+
+    for (size_t chunk = 0; chunk < no_of_chunks; ++chunk)
+        start_worker(chunk);
+
+    while (!running.empty())
+    {
+        int status = 0;
+        const auto [pid, chunk] = running.wait(status);
+        if (pid == -1)
+            throw std::runtime_error("waiting for multi-process workers failed: " + std::string{std::strerror(errno)});
+
+        const bool published = results[chunk].done.load(std::memory_order_acquire) == 1;
+        if (published && WIFEXITED(status) && WEXITSTATUS(status) == 0)
+            continue;
+
+        if (attempts[chunk] >= max_attempts)
+            throw std::runtime_error("multi-process worker for chunk " + std::to_string(chunk) + " failed "
+                + std::to_string(attempts[chunk]) + " times");
+
+        results[chunk].done.store(0, std::memory_order_relaxed);
+        ++restarts;
+        start_worker(chunk);
+    }
+
+    uintmax_t hits = 0;
+    for (size_t chunk = 0; chunk < no_of_chunks; ++chunk)
+        hits += results[chunk].hits.load(std::memory_order_relaxed);
+
+    return {hits, restarts};
+#else
+    (void)count, (void)no_of_processes, (void)seed, (void)max_attempts, (void)worker_hook;
+    throw std::runtime_error("multi-process mode requires fork() and POSIX shared memory");
+#endif
+}
@@ -0,0 +1,25 @@
+#ifndef MULTI_PROCESS_HPP
+#define MULTI_PROCESS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#include "calc_hits.hpp"
+
+struct MultiProcessResult
+{
+    uintmax_t hits;
+    size_t restarts; // workers that had to be re-forked after a crash
+};
+
+// Forks no_of_processes workers; worker i runs calc_hits over samples [N * i / K, N * (i + 1) / K) with
+// the i-th jump() stream of seed and publishes its count in a POSIX shared memory segment, which the parent reduces.
+// A worker that dies before publishing is re-forked for the same chunk (up to max_attempts per chunk), so
+// the result is the same as without crashes. Throws std::runtime_error when a chunk keeps failing.
+// worker_hook(chunk, attempt) runs in the child before sampling - used by the tests to inject crashes. The child is
+// forked from a process that may have other threads, so the hook must be async-signal-safe (no allocation, no locks).
+MultiProcessResult calc_hits_multi_process(uintmax_t count, size_t no_of_processes, uint64_t seed = default_seed,
+    size_t max_attempts = 3, const std::function<void(size_t, size_t)>& worker_hook = {});
+
+#endif
@@ -0,0 +1,158 @@
+#ifndef PER_THREAD_HPP
+#define PER_THREAD_HPP
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <numeric>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+// 64 bytes on x86-64 and most ARM cores; std::hardware_destructive_interference_size
+// is not used because its value may differ between translation units
+constexpr size_t cache_line_size = 64;
+
+template <typename T>
+struct alignas(cache_line_size) CacheLinePadded
+{
+    T value{};
+};
+
+// enumerable_thread_specific-style storage: one cache-line-aligned slot per worker,
+// so workers updating their own slots never share a cache line.
+// Slots are addressed by worker id (as passed by run_work_stealing) rather than by thread::id.
+template <typename T>
+class PerThread
+{
+    std::vector<CacheLinePadded<T>> slots_;
+
+public:
+    using value_type = T;
+
+    explicit PerThread(size_t no_of_slots, const T& init = T{})
+        : slots_(no_of_slots, CacheLinePadded<T>{init})
+    {
+    }
+
+    T& local(size_t id)
+    {
+        return slots_[id].value;
+    }
+
+    const T& local(size_t id) const
+    {
+        return slots_[id].value;
+    }
+
+    size_t size() const
+    {
+        return slots_.size();
+    }
+
+    template <typename BinaryOp>
+    T combine(BinaryOp op, T init = T{}) const
+    {
+        return std::accumulate(slots_.begin(), slots_.end(), init,
+            [&op](const T& acc, const CacheLinePadded<T>& slot) { return op(acc, slot.value); });
+    }
+
+    T combine() const
+    {
+        return combine([](const T& a, const T& b) { return a + b; });
+    }
+
+    template <typename F>
+    void combine_each(F f) const
+    {
+        for (const auto& slot : slots_)
+            f(slot.value);
+    }
+};
+
+// Same interface as PerThread, but every slot gets its own fresh pages, mapped and constructed by the first
+// local(id) call. When that call is made by worker id itself, Linux's first-touch policy places the slot
+// on the NUMA node the worker runs on (see ScopedPin in topology.hpp).
+// local(id) must only be called by worker id until the workers have been joined.
+constexpr size_t page_size = 4096;
+
+template <typename T>
+class NodeLocal
+{
+    static constexpr size_t slot_bytes = (sizeof(T) + page_size - 1) / page_size * page_size;
+
+    struct SlotDeleter
+    {
+        void operator()(T* slot) const
+        {
+            slot->~T();
+#ifdef __linux__
+            munmap(slot, slot_bytes);
+#else
+            ::operator delete(slot, std::align_val_t{page_size});
+#endif
+        }
+    };
+
+    std::vector<std::unique_ptr<T, SlotDeleter>> slots_;
+    T init_;
+
+    static void* allocate_pages()
+    {
+#ifdef __linux__
+        // mmap rather than the heap - recycled heap pages would keep the node of their first owner
+        void* memory = mmap(nullptr, slot_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED)
+            throw std::bad_alloc{};
+        return memory;
+#else
+        return ::operator new(slot_bytes, std::align_val_t{page_size});
+#endif
+    }
+
+public:
+    using value_type = T;
+
+    explicit NodeLocal(size_t no_of_slots, const T& init = T{})
+        : slots_(no_of_slots), init_{init}
+    {
+    }
+
+    T& local(size_t id)
+    {
+        auto& slot = slots_[id];
+        if (!slot)
+            slot.reset(new (allocate_pages()) T(init_));
+        return *slot;
+    }
+
+    size_t size() const
+    {
+        return slots_.size();
+    }
+
+    // slots never touched by their worker contribute init
+    template <typename BinaryOp>
+    T combine(BinaryOp op, T init = T{}) const
+    {
+        for (const auto& slot : slots_)
+            init = op(init, slot ? *slot : init_);
+        return init;
+    }
+
+    T combine() const
+    {
+        return combine([](const T& a, const T& b) { return a + b; });
+    }
+
+    template <typename F>
+    void combine_each(F f) const
+    {
+        for (const auto& slot : slots_)
+            f(slot ? *slot : init_);
+    }
+};
+
+#endif
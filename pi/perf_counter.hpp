@@ -0,0 +1,67 @@
+#ifndef PERF_COUNTER_HPP
+#define PERF_COUNTER_HPP
+
+#include <cstdint>
+#include <optional>
+
+#ifdef __linux__
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Hardware cache-miss counter for the calling thread and all threads it creates afterwards.
+// read() returns nullopt when perf events are unavailable (non-Linux, VM without PMU, perf_event_paranoid).
+class CacheMissCounter
+{
+    int fd_ = -1;
+
+public:
+    CacheMissCounter()
+    {
+#ifdef __linux__
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled = 1;
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+
+        fd_ = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        if (fd_ != -1)
+        {
+            ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    CacheMissCounter(const CacheMissCounter&) = delete;
+    CacheMissCounter& operator=(const CacheMissCounter&) = delete;
+
+    ~CacheMissCounter()
+    {
+#ifdef __linux__
+        if (fd_ != -1)
+            close(fd_);
+#endif
+    }
+
+    // call after all counted threads have been joined
+    std::optional<uint64_t> read() const
+    {
+#ifdef __linux__
+        uint64_t value = 0;
+        if (fd_ != -1 && ::read(fd_, &value, sizeof(value)) == sizeof(value))
+            return value;
+#endif
+        return std::nullopt;
+    }
+};
+
+#endif
@@ -0,0 +1,146 @@
+#ifndef RNG_HPP
+#define RNG_HPP
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "splitmix64.hpp"
+
+// xoshiro256** (Blackman & Vigna) - 256 bits of state, period 2^256 - 1
+// satisfies UniformRandomBitGenerator, so it can be used with <random> distributions
+class Xoshiro256StarStar
+{
+    std::array<uint64_t, 4> s_;
+
+    static constexpr uint64_t rotl(uint64_t x, int k)
+    {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    void jump(const std::array<uint64_t, 4>& polynomial)
+    {
+        std::array<uint64_t, 4> t{};
+
+        for (uint64_t word : polynomial)
+            for (int b = 0; b < 64; ++b)
+            {
+                if (word & (uint64_t{1} << b))
+                    for (size_t i = 0; i < t.size(); ++i)
+                        t[i] ^= s_[i];
+                (*this)();
+            }
+
+        s_ = t;
+    }
+
+public:
+    using result_type = uint64_t;
+
+    explicit Xoshiro256StarStar(uint64_t seed = 0)
+    {
+        SplitMix64 sm{seed};
+        for (auto& word : s_)
+            word = sm();
+    }
+
+    explicit Xoshiro256StarStar(const std::array<uint64_t, 4>& state)
+        : s_{state}
+    {
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    result_type operator()()
+    {
+        const uint64_t result = rotl(s_[1] * 5, 7) * 9;
+        const uint64_t t = s_[1] << 17;
+
+        s_[2] ^= s_[0];
+        s_[3] ^= s_[1];
+        s_[1] ^= s_[2];
+        s_[0] ^= s_[3];
+        s_[2] ^= t;
+        s_[3] = rotl(s_[3], 45);
+
+        return result;
+    }
+
+    // equivalent to 2^128 calls to operator() - gives 2^128 non-overlapping subsequences
+    void jump()
+    {
+        jump({0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL});
+    }
+
+    // equivalent to 2^192 calls to operator() - gives 2^64 starting points, each with 2^64 jump() streams
+    void long_jump()
+    {
+        jump({0x76e15d3efefdcbbfULL, 0xc5004e441c522fb3ULL, 0x77710069854ee241ULL, 0x39109bb02acbe635ULL});
+    }
+
+    const std::array<uint64_t, 4>& state() const
+    {
+        return s_;
+    }
+
+    bool operator==(const Xoshiro256StarStar&) const = default;
+};
+
+// Stream k starts 2^128 * k draws after the seeded state, so streams never overlap
+// unless one of them draws more than 2^128 numbers.
+inline std::vector<Xoshiro256StarStar> make_streams(uint64_t seed, size_t count)
+{
+    std::vector<Xoshiro256StarStar> streams;
+    streams.reserve(count);
+
+    Xoshiro256StarStar gen{seed};
+    for (size_t i = 0; i < count; ++i)
+    {
+        streams.push_back(gen);
+        gen.jump();
+    }
+
+    return streams;
+}
+
+// k generators for parallel use: jump() streams for xoshiro256**; other engines (e.g. mt19937_64) have no cheap
+// jump-ahead and are seeded from a SplitMix64 sequence - independent in practice, but not provably
+template <typename RndGen>
+std::vector<RndGen> make_generators(uint64_t seed, size_t count)
+{
+    if constexpr (std::is_same_v<RndGen, Xoshiro256StarStar>)
+        return make_streams(seed, count);
+    else
+    {
+        std::vector<RndGen> generators;
+        generators.reserve(count);
+
+        SplitMix64 seeds{seed};
+        for (size_t i = 0; i < count; ++i)
+            generators.emplace_back(seeds());
+
+        return generators;
+    }
+}
+
+// The generator of block b - the same as make_generators<RndGen>(seed, n)[b] for engines seeded from SplitMix64,
+// a xoshiro256** state seeded from the b-th SplitMix64 number of seed for xoshiro256** (no jump() chain, which
+// would cost b jumps). O(1) from (seed, b) alone, so blocks can be set up when claimed, in any order, on any thread.
+template <typename RndGen>
+RndGen block_generator(uint64_t seed, uint64_t block)
+{
+    SplitMix64 seeds{seed + block * SplitMix64::gamma};
+    return RndGen{seeds()};
+}
+
+// 53 random bits -> double in [0, 1)
+template <typename RndGen>
+double uniform_double(RndGen& rnd_gen)
+{
+    return static_cast<double>(rnd_gen() >> 11) * 0x1.0p-53;
+}
+
+#endif
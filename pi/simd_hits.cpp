@@ -0,0 +1,163 @@
+#include "simd_hits.hpp"
+
+#include <bit>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define SIMD_HITS_X86
+#define SIMD_TARGET(isa) __attribute__((target(isa)))
+#define SIMD_INLINE __attribute__((always_inline)) inline
+#else
+#define SIMD_INLINE inline
+#endif
+
+namespace
+{
+    constexpr uint64_t golden_gamma = 0x9E3779B97F4A7C15ULL;
+
+    // SplitMix64 finalizer - sample i uses states seed + (2i + 1) * gamma and seed + (2i + 2) * gamma
+    SIMD_INLINE uint64_t mix64(uint64_t z)
+    {
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    // 52 random bits as mantissa of a double in [1, 2) - integer ops only, so it vectorizes on every ISA
+    SIMD_INLINE double to_unit_double(uint64_t bits)
+    {
+        return std::bit_cast<double>((bits >> 12) | 0x3FF0000000000000ULL) - 1.0;
+    }
+
+    SIMD_INLINE bool is_hit(uint64_t seed, uintmax_t sample)
+    {
+        const uint64_t counter = 2 * static_cast<uint64_t>(sample);
+        const double x = to_unit_double(mix64(seed + (counter + 1) * golden_gamma));
+        const double y = to_unit_double(mix64(seed + (counter + 2) * golden_gamma));
+
+        return x * x + y * y < 1.0;
+    }
+
+    // Lanes independent samples per iteration; no branches in the inner loop, so the compiler
+    // emits one vector lane per sample for the ISA of the calling function
+    template <size_t Lanes>
+    SIMD_INLINE uintmax_t count_hits_lanes(uint64_t seed, uintmax_t first, uintmax_t count)
+    {
+        uint64_t lane_hits[Lanes] = {};
+
+        const uintmax_t full = count - count % Lanes;
+        for (uintmax_t n = 0; n < full; n += Lanes)
+            for (size_t l = 0; l < Lanes; ++l)
+                lane_hits[l] += is_hit(seed, first + n + l);
+
+        uintmax_t hits = 0;
+        for (size_t l = 0; l < Lanes; ++l)
+            hits += lane_hits[l];
+
+        for (uintmax_t n = full; n < count; ++n)
+            hits += is_hit(seed, first + n);
+
+        return hits;
+    }
+
+    uintmax_t count_hits_scalar(uint64_t seed, uintmax_t first, uintmax_t count)
+    {
+        return count_hits_lanes<1>(seed, first, count);
+    }
+
+#ifdef SIMD_HITS_X86
+    SIMD_TARGET("sse2") uintmax_t count_hits_sse2(uint64_t seed, uintmax_t first, uintmax_t count)
+    {
+        return count_hits_lanes<4>(seed, first, count);
+    }
+
+    SIMD_TARGET("avx2") uintmax_t count_hits_avx2(uint64_t seed, uintmax_t first, uintmax_t count)
+    {
+        return count_hits_lanes<8>(seed, first, count);
+    }
+
+    SIMD_TARGET("avx512f,avx512dq") uintmax_t count_hits_avx512(uint64_t seed, uintmax_t first, uintmax_t count)
+    {
+        return count_hits_lanes<16>(seed, first, count);
+    }
+#endif
+
+    bool is_supported(SimdPath path)
+    {
+        switch (path)
+        {
+        case SimdPath::scalar:
+            return true;
+#ifdef SIMD_HITS_X86
+        case SimdPath::sse2:
+            return __builtin_cpu_supports("sse2");
+        case SimdPath::avx2:
+            return __builtin_cpu_supports("avx2");
+        case SimdPath::avx512:
+            return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq");
+#endif
+        default:
+            return false;
+        }
+    }
+}
+
+std::string_view to_string(SimdPath path)
+{
+    switch (path)
+    {
+    case SimdPath::scalar:
+        return "scalar";
+    case SimdPath::sse2:
+        return "sse2";
+    case SimdPath::avx2:
+        return "avx2";
+    case SimdPath::avx512:
+        return "avx512";
+    }
+
+    return "unknown";
+}
+
+std::vector<SimdPath> supported_simd_paths()
+{
+    std::vector<SimdPath> paths;
+    for (auto path : {SimdPath::scalar, SimdPath::sse2, SimdPath::avx2, SimdPath::avx512})
+        if (is_supported(path))
+            paths.push_back(path);
+
+    return paths;
+}
+
+SimdPath best_simd_path()
+{
+    static const SimdPath best = supported_simd_paths().back();
+    return best;
+}
+
+uintmax_t count_hits_simd(SimdPath path, uint64_t seed, uintmax_t first, uintmax_t count)
+{
+    if (!is_supported(path))
+        throw std::invalid_argument("SIMD path not supported on this CPU: " + std::string(to_string(path)));
+
+    switch (path)
+    {
+#ifdef SIMD_HITS_X86
+    case SimdPath::sse2:
+        return count_hits_sse2(seed, first, count);
+    case SimdPath::avx2:
+        return count_hits_avx2(seed, first, count);
+    case SimdPath::avx512:
+        return count_hits_avx512(seed, first, count);
+#endif
+    default:
+        return count_hits_scalar(seed, first, count);
+    }
+}
+
+uintmax_t count_hits_simd(uint64_t seed, uintmax_t first, uintmax_t count)
+{
+    return count_hits_simd(best_simd_path(), seed, first, count);
+}
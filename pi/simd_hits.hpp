@@ -0,0 +1,30 @@
+#ifndef SIMD_HITS_HPP
+#define SIMD_HITS_HPP
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+enum class SimdPath
+{
+    scalar,
+    sse2,
+    avx2,
+    avx512
+};
+
+std::string_view to_string(SimdPath path);
+
+// paths that can run on this CPU (checked at runtime with CPUID); scalar is always first
+std::vector<SimdPath> supported_simd_paths();
+
+SimdPath best_simd_path();
+
+// Counts hits for samples [first, first + count) of the counter-based stream selected by seed.
+// Sample i depends only on (seed, i) - the result does not depend on how samples are split into blocks.
+uintmax_t count_hits_simd(SimdPath path, uint64_t seed, uintmax_t first, uintmax_t count);
+
+// uses best_simd_path()
+uintmax_t count_hits_simd(uint64_t seed, uintmax_t first, uintmax_t count);
+
+#endif
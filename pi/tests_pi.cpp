@@ -0,0 +1,578 @@
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <numbers>
+#include <random>
+#include <string>
+#include <thread>
+
+#include <sys/wait.h>
+
+#include "big_int.hpp"
+#include "calc_hits.hpp"
+#include "checkpoint.hpp"
+#include "chudnovsky.hpp"
+#include "convergence.hpp"
+#include "low_discrepancy.hpp"
+#include "monte_carlo.hpp"
+#include "multi_process.hpp"
+#include "per_thread.hpp"
+#include "rng.hpp"
+#include "simd_hits.hpp"
+#include "topology.hpp"
+
+TEST_CASE("SIMD hit counting")
+{
+    const uint64_t seed = 665;
+    const uintmax_t N = 4'000'003; // not a multiple of any lane count - tails are covered too
+
+    // hits ~ Binomial(N, pi/4)
+    const double p = std::numbers::pi / 4;
+    const double sigma = std::sqrt(N * p * (1 - p));
+
+    const uintmax_t scalar_hits = count_hits_simd(SimdPath::scalar, seed, 0, N);
+
+    REQUIRE(std::abs(static_cast<double>(scalar_hits) - N * p) < 5 * sigma);
+
+    for (SimdPath path : supported_simd_paths())
+    {
+        SECTION(std::string(to_string(path)) + " path gives statistically equivalent estimate")
+        {
+            const uintmax_t hits = count_hits_simd(path, seed, 0, N);
+
+            CHECK(std::abs(static_cast<double>(hits) - N * p) < 5 * sigma);
+            // same stream in every path - only FMA contraction may flip a point lying on the circle
+            CHECK(std::abs(static_cast<double>(hits) - static_cast<double>(scalar_hits)) <= 1);
+        }
+
+        SECTION(std::string(to_string(path)) + " path - splitting into blocks does not change result")
+        {
+            const uintmax_t block = 1'000'001;
+            uintmax_t hits = 0;
+            for (uintmax_t first = 0; first < N; first += block)
+                hits += count_hits_simd(path, seed, first, std::min(block, N - first));
+
+            CHECK(hits == count_hits_simd(path, seed, 0, N));
+        }
+    }
+}
+
+TEST_CASE("transform_reduce backend matches hand-rolled threads")
+{
+    const uintmax_t N = 3'000'001;
+
+    CHECK(calc_hits_transform_reduce(N, 42, 1 << 16) == calc_hits_simd(N, 3, 42, 1 << 16));
+}
+
+TEST_CASE("xoshiro256**")
+{
+    // reference values from the authors' C implementation
+    Xoshiro256StarStar rnd_gen{{1, 2, 3, 4}};
+
+    SECTION("sequence")
+    {
+        CHECK(rnd_gen() == 11520ULL);
+        CHECK(rnd_gen() == 0ULL);
+        CHECK(rnd_gen() == 1509978240ULL);
+    }
+
+    SECTION("jump")
+    {
+        for (int i = 0; i < 3; ++i)
+            rnd_gen();
+        rnd_gen.jump();
+
+        CHECK(rnd_gen() == 11547880530658420384ULL);
+        CHECK(rnd_gen() == 10982751773866918481ULL);
+    }
+
+    SECTION("works with <random> distributions")
+    {
+        std::uniform_int_distribution<int> rnd(1, 6);
+
+        for (int i = 0; i < 100; ++i)
+        {
+            const int value = rnd(rnd_gen);
+            CHECK((value >= 1 && value <= 6));
+        }
+    }
+}
+
+TEST_CASE("make_streams")
+{
+    const auto streams = make_streams(42, 3);
+
+    REQUIRE(streams.size() == 3);
+    CHECK(streams == make_streams(42, 3));
+    CHECK(streams[0] == Xoshiro256StarStar{42});
+
+    Xoshiro256StarStar second{42};
+    second.jump();
+    CHECK(streams[1] == second);
+}
+
+TEST_CASE("work-stealing pi is reproducible")
+{
+    const uintmax_t N = 1'000'003;
+
+    const uintmax_t hits = calc_hits_work_stealing(N, 1, 665, 4096);
+
+    for (size_t no_of_threads : {2, 3, 8})
+        CHECK(calc_hits_work_stealing(N, no_of_threads, 665, 4096) == hits);
+
+    CHECK(calc_hits_work_stealing(N, 4, 666, 4096) != hits);
+
+    // block generators need no setup proportional to the number of blocks
+    CHECK(block_generator<std::mt19937_64>(665, 5) == make_generators<std::mt19937_64>(665, 6)[5]);
+    CHECK(block_generator<Xoshiro256StarStar>(665, 5) != block_generator<Xoshiro256StarStar>(665, 6));
+    CHECK(calc_hits_work_stealing(N, 2, 665, 1) == calc_hits_work_stealing(N, 3, 665, 1));
+}
+
+TEST_CASE("PerThread")
+{
+    PerThread<uintmax_t> hits(4, 1);
+
+    CHECK(hits.size() == 4);
+    CHECK(sizeof(CacheLinePadded<uintmax_t>) == cache_line_size);
+    CHECK(reinterpret_cast<uintptr_t>(&hits.local(1)) - reinterpret_cast<uintptr_t>(&hits.local(0)) == cache_line_size);
+
+    hits.local(2) += 10;
+
+    CHECK(hits.combine() == 14);
+    CHECK(hits.combine([](uintmax_t a, uintmax_t b) { return std::max(a, b); }) == 11);
+
+    uintmax_t visited = 0;
+    hits.combine_each([&](uintmax_t value) { visited += value; });
+    CHECK(visited == 14);
+}
+
+TEST_CASE("low-discrepancy sequences")
+{
+    SECTION("Halton - radical inverse in bases 2 and 3")
+    {
+        HaltonSequence<2> halton;
+
+        CHECK(halton[1] == std::array{1.0 / 2, 1.0 / 3});
+        CHECK(halton[2] == std::array{1.0 / 4, 2.0 / 3});
+        CHECK(halton[3] == std::array{3.0 / 4, 1.0 / 9});
+    }
+
+    SECTION("Sobol - first points")
+    {
+        SobolSequence<2> sobol;
+
+        CHECK(sobol[0] == std::array{0.0, 0.0});
+        CHECK(sobol[1] == std::array{0.5, 0.5});
+        CHECK(sobol[2] == std::array{0.75, 0.25});
+        CHECK(sobol[3] == std::array{0.25, 0.75});
+    }
+
+    SECTION("Sobol - incremental generation matches direct indexing")
+    {
+        SobolSequence<3> sobol{665};
+
+        uint64_t index = 100;
+        sobol.for_each_point(100, 50, [&](const std::array<double, 3>& point) { CHECK(point == sobol[index++]); });
+        CHECK(index == 150);
+    }
+
+    SECTION("Sobol - indices beyond 2^32 are rejected")
+    {
+        SobolSequence<2> sobol{665};
+        const uint64_t last = SobolSequence<2>::max_points - 1;
+
+        size_t points = 0;
+        sobol.for_each_point(last - 2, 3, [&](const std::array<double, 2>&) { ++points; });
+        CHECK(points == 3);
+        CHECK_NOTHROW(sobol[last]);
+
+        CHECK_THROWS_AS(sobol[last + 1], std::out_of_range);
+        CHECK_THROWS_AS(sobol.for_each_point(last, 2, [](const std::array<double, 2>&) {}), std::out_of_range);
+        CHECK_THROWS_AS(sobol.for_each_point(UINT64_MAX, 2, [](const std::array<double, 2>&) {}), std::out_of_range);
+    }
+
+    SECTION("Sobol - every 1D projection of the first 2^k points is stratified")
+    {
+        constexpr unsigned k = 10;
+        SobolSequence<8> sobol{42}; // a digital shift preserves stratification
+
+        for (size_t d = 0; d < 8; ++d)
+        {
+            std::vector<int> cells(1 << k);
+            for (uint64_t i = 0; i < cells.size(); ++i)
+                ++cells[static_cast<size_t>(sobol[i][d] * cells.size())];
+
+            CHECK(std::all_of(cells.begin(), cells.end(), [](int c) { return c == 1; }));
+        }
+    }
+}
+
+TEST_CASE("convergence-driven pi estimate")
+{
+    const double tolerance = 1e-3;
+
+    const ConvergenceResult pseudo = estimate_pi_until(tolerance, SampleSource::pseudo_random);
+    const ConvergenceResult sobol = estimate_pi_until(tolerance, SampleSource::sobol);
+    const ConvergenceResult halton = estimate_pi_until(tolerance, SampleSource::halton);
+
+    for (const auto& result : {pseudo, sobol, halton})
+    {
+        CHECK(result.converged);
+        CHECK(std::abs(result.pi - std::numbers::pi) < 2 * tolerance);
+    }
+
+    CHECK(sobol.samples * 100 < pseudo.samples);
+    CHECK(halton.samples * 10 < pseudo.samples);
+}
+
+TEST_CASE("monte_carlo_integrate")
+{
+    SECTION("linear function in 3D")
+    {
+        auto result = monte_carlo_integrate<3>([](const std::array<double, 3>& x) { return x[0] + x[1] + x[2]; },
+            unit_box<3>(), 1'000'000);
+
+        CHECK(result.samples == 1'000'000);
+        CHECK(std::abs(result.estimate - 1.5) < 5 * result.std_error);
+        CHECK(result.variance > 0);
+    }
+
+    SECTION("scaled domain")
+    {
+        auto result = monte_carlo_integrate<1>([](const std::array<double, 1>& x) { return x[0] * x[0]; },
+            Box<1>{{0.0}, {2.0}}, 1'000'000);
+
+        CHECK(std::abs(result.estimate - 8.0 / 3) < 5 * result.std_error);
+    }
+
+    SECTION("pi as area of the unit circle")
+    {
+        auto in_circle = [](const std::array<double, 2>& p) { return (p[0] * p[0] + p[1] * p[1] < 1.0) ? 1.0 : 0.0; };
+        const Box<2> square{{-1.0, -1.0}, {1.0, 1.0}};
+
+        auto sequential = monte_carlo_integrate<2>(in_circle, square, 1'000'003, Sequential{});
+        auto partitioned = monte_carlo_integrate<2>(in_circle, square, 1'000'003, StaticPartition{3});
+        auto work_stealing = monte_carlo_integrate<2>(in_circle, square, 1'000'003, WorkStealing{4});
+
+        CHECK(std::abs(sequential.estimate - std::numbers::pi) < 5 * sequential.std_error);
+        CHECK(partitioned.estimate == sequential.estimate);
+        CHECK(work_stealing.estimate == sequential.estimate);
+        CHECK(work_stealing.variance == sequential.variance);
+    }
+
+    SECTION("constant integrand has zero variance")
+    {
+        auto result = monte_carlo_integrate<2>([](const std::array<double, 2>&) { return 2.0; }, unit_box<2>(), 1000);
+
+        CHECK(result.estimate == 2.0);
+        CHECK(result.variance == 0.0);
+    }
+}
+
+TEST_CASE("BigInt")
+{
+    SECTION("decimal round trip")
+    {
+        CHECK(BigInt("0").to_string() == "0");
+        CHECK(BigInt("-000123").to_string() == "-123");
+        CHECK(BigInt("1000000000000000000000").to_string() == "1000000000000000000000");
+        CHECK(BigInt(-9'223'372'036'854'775'807 - 1).to_string() == "-9223372036854775808");
+        CHECK_THROWS(BigInt("12a"));
+    }
+
+    SECTION("addition and subtraction")
+    {
+        const BigInt a("999999999999999999");
+        CHECK((a + 1).to_string() == "1000000000000000000");
+        CHECK((1 - a).to_string() == "-999999999999999998");
+        CHECK((a - a).is_zero());
+        CHECK(!(a - a).is_negative());
+        CHECK(BigInt(-5) < BigInt(3));
+        CHECK(BigInt(-5) < BigInt(-3));
+    }
+
+    SECTION("multiplication algorithms agree")
+    {
+        std::mt19937_64 rnd_gen{42};
+        auto random_number = [&](size_t limbs) {
+            std::vector<BigInt::Limb> mag(limbs);
+            for (auto& limb : mag)
+                limb = rnd_gen() % BigInt::base;
+            mag.back() = std::max<BigInt::Limb>(mag.back(), 1);
+            return BigInt::from_limbs(mag);
+        };
+
+        for (auto [na, nb] : {std::pair{3, 2}, {50, 45}, {300, 17}, {2000, 1500}})
+        {
+            const BigInt a = random_number(na);
+            const BigInt b = -random_number(nb);
+
+            const BigInt expected = multiply(a, b, MulAlgorithm::schoolbook);
+            CHECK(expected.is_negative());
+            CHECK(multiply(a, b, MulAlgorithm::karatsuba) == expected);
+            CHECK(multiply(a, b, MulAlgorithm::fft) == expected);
+            CHECK(a * b == expected);
+        }
+    }
+
+    SECTION("reciprocal and inverse square root")
+    {
+        const BigInt x("123456789012345678901234567890");
+        const size_t precision = 40;
+
+        // x * R ~ base^(x.size() + precision)
+        const BigInt error = x * reciprocal(x, precision) - BigInt(1).shifted_limbs(x.size() + precision);
+        CHECK(error < x.shifted_limbs(1));
+        CHECK(-x.shifted_limbs(1) < error);
+
+        // a * Y^2 ~ base^(2 precision)
+        const BigInt y = inverse_sqrt(10005, precision);
+        BigInt ay2 = y * y;
+        ay2 *= 10005u;
+        const BigInt sqrt_error = ay2 - BigInt(1).shifted_limbs(2 * precision);
+        CHECK(sqrt_error < BigInt(1).shifted_limbs(precision + 1));
+        CHECK(-BigInt(1).shifted_limbs(precision + 1) < sqrt_error);
+    }
+}
+
+TEST_CASE("Chudnovsky pi")
+{
+    CHECK(chudnovsky_pi(1, 1) == "3.1");
+    CHECK(chudnovsky_pi(50, 1) == "3.14159265358979323846264338327950288419716939937510");
+
+    const std::string pi = chudnovsky_pi(10'000, 4);
+    CHECK(pi.size() == 10'002);
+    CHECK(pi.ends_with("5256375678"));
+    CHECK(verify_pi_digits(pi));
+    CHECK(chudnovsky_pi(10'000, 1) == pi);
+
+    CHECK(verify_pi_digits(chudnovsky_pi(100'000, 2)));
+    CHECK(!verify_pi_digits("3.1415926535897932384626433832795028841971693993751058209749445923078164062862089986280348253421170678"));
+}
+
+TEST_CASE("CPU topology and placement")
+{
+    CHECK(parse_cpu_list("0-3,8,10-11\n") == std::vector<unsigned>{0, 1, 2, 3, 8, 10, 11});
+    CHECK(parse_cpu_list("").empty());
+
+    // 2 sockets = 2 NUMA nodes, 2 cores per socket, 2 hardware threads per core (Linux numbering: siblings are +4)
+    const auto root = std::filesystem::temp_directory_path() / "pi_tests_sysfs";
+    std::filesystem::remove_all(root);
+
+    auto write = [&](const std::filesystem::path& path, const std::string& text) {
+        std::filesystem::create_directories((root / path).parent_path());
+        std::ofstream{root / path} << text << "\n";
+    };
+
+    write("cpu/online", "0-7");
+    for (unsigned cpu = 0; cpu < 8; ++cpu)
+    {
+        const std::string dir = "cpu/cpu" + std::to_string(cpu) + "/topology/";
+        write(dir + "core_id", std::to_string(cpu % 2));
+        write(dir + "physical_package_id", std::to_string(cpu % 4 / 2));
+    }
+    write("node/node0/cpulist", "0-1,4-5");
+    write("node/node1/cpulist", "2-3,6-7");
+
+    const CpuTopology topology = CpuTopology::detect(root);
+    std::filesystem::remove_all(root);
+
+    CHECK(topology.cpus().size() == 8);
+    CHECK(topology.no_of_nodes() == 2);
+    CHECK(topology.no_of_cores() == 4);
+
+    CHECK(assign_cpus(topology, Placement::none, 4).empty());
+    CHECK(assign_cpus(topology, Placement::compact, 4) == std::vector<unsigned>{0, 1, 4, 5});
+    CHECK(assign_cpus(topology, Placement::spread, 4) == std::vector<unsigned>{0, 2, 1, 3});
+    CHECK(assign_cpus(topology, Placement::spread, 10) == std::vector<unsigned>{0, 2, 1, 3, 4, 6, 5, 7, 0, 2});
+
+    // e.g. started with taskset -c 1-3,6
+    const CpuTopology allowed = topology.restricted_to({1, 2, 3, 6});
+    CHECK(allowed.cpus().size() == 4);
+    CHECK(assign_cpus(allowed, Placement::compact, 4) == std::vector<unsigned>{1, 2, 3, 6});
+    CHECK(assign_cpus(allowed, Placement::spread, 4) == std::vector<unsigned>{1, 2, 3, 6});
+    CHECK(topology.restricted_to({}).cpus().size() == 8);
+
+    CHECK(placement_from_string("spread") == Placement::spread);
+    CHECK_THROWS(placement_from_string("scatter"));
+
+    SECTION("detected topology and pinning")
+    {
+        const std::vector<unsigned> allowed = current_affinity();
+        REQUIRE(!allowed.empty());
+
+        const CpuTopology local = CpuTopology::detect().restricted_to(allowed);
+        CHECK(local.no_of_nodes() >= 1);
+        for (const auto& cpu : local.cpus())
+            CHECK(std::find(allowed.begin(), allowed.end(), cpu.id) != allowed.end());
+
+        const size_t failures = ScopedPin::no_of_failures();
+        {
+            const ScopedPin pin{{allowed.back()}, 0};
+            CHECK(pin.pinned());
+            CHECK(current_affinity() == std::vector<unsigned>{allowed.back()});
+        }
+        CHECK(current_affinity() == allowed);
+        CHECK(ScopedPin::no_of_failures() == failures);
+
+        {
+            const ScopedPin pin{{1023}, 0}; // no such CPU
+            CHECK(!pin.pinned());
+            CHECK(current_affinity() == allowed);
+        }
+        CHECK(current_affinity() == allowed);
+        CHECK(ScopedPin::no_of_failures() == failures + 1);
+
+        const auto cpus = assign_cpus(local, Placement::compact, 3);
+        CHECK(calc_hits_work_stealing(1'000'000, 3, 665, 4096, cpus) == calc_hits_work_stealing(1'000'000, 1, 665, 4096));
+    }
+}
+
+TEST_CASE("NodeLocal")
+{
+    NodeLocal<uintmax_t> counters(4, 1);
+    run_work_stealing(1000, 10, 4, [&](size_t id, const SampleBlock& block) { counters.local(id) += block.count; });
+
+    CHECK(counters.combine() == 1000 + 4);
+    CHECK(reinterpret_cast<uintptr_t>(&counters.local(0)) % page_size == 0);
+}
+
+TEST_CASE("multi-process pi")
+{
+    const uintmax_t N = 1'000'000;
+
+    const MultiProcessResult result = calc_hits_multi_process(N, 3, 665);
+    CHECK(result.restarts == 0);
+    CHECK(std::abs(4.0 * result.hits / N - std::numbers::pi) < 0.01);
+
+    SECTION("crashed workers are restarted for the same chunk")
+    {
+        const MultiProcessResult crashed = calc_hits_multi_process(N, 3, 665, 3, [](size_t chunk, size_t attempt) {
+            if (chunk == 1 && attempt < 2)
+                std::raise(SIGKILL);
+        });
+
+        CHECK(crashed.restarts == 2);
+        CHECK(crashed.hits == result.hits);
+    }
+
+    SECTION("gives up on a chunk that keeps failing")
+    {
+        CHECK_THROWS_AS(calc_hits_multi_process(N, 3, 665, 2, [](size_t chunk, size_t) {
+            if (chunk == 0)
+                std::_Exit(1);
+            std::this_thread::sleep_for(std::chrono::seconds(10));
+        }), std::runtime_error);
+
+        // the sleeping workers were killed and reaped
+        CHECK(waitpid(-1, nullptr, WNOHANG) == -1);
+        CHECK(errno == ECHILD);
+    }
+
+    SECTION("children that are not workers are left alone")
+    {
+        const pid_t other = fork();
+        REQUIRE(other != -1);
+        if (other == 0)
+            std::_Exit(7);
+
+        CHECK(calc_hits_multi_process(N, 3, 665).hits == result.hits);
+
+        int status = 0;
+        CHECK(waitpid(other, &status, 0) == other);
+        CHECK(WEXITSTATUS(status) == 7);
+    }
+}
+
+TEST_CASE("checkpoint and resume")
+{
+    const auto file = std::filesystem::temp_directory_path() / "pi_tests.checkpoint";
+    std::filesystem::remove(file);
+
+    SECTION("file round trip")
+    {
+        const Checkpoint checkpoint{1000, 42, {{10, 7, {1, 2, 3, 4}}, {0, 0, {5, 6, 7, 8}}}};
+        save_checkpoint(file, checkpoint);
+        CHECK(load_checkpoint(file) == checkpoint);
+
+        // flip one byte of the payload
+        {
+            std::fstream f{file, std::ios::in | std::ios::out | std::ios::binary};
+            f.seekp(30);
+            f.put('x');
+        }
+        CHECK_THROWS_AS(load_checkpoint(file), std::runtime_error);
+
+        std::filesystem::resize_file(file, 20);
+        CHECK_THROWS_AS(load_checkpoint(file), std::runtime_error);
+
+        std::filesystem::remove(file);
+        CHECK(!load_checkpoint(file));
+    }
+
+    SECTION("resumed run matches an uninterrupted one")
+    {
+        const uintmax_t N = 2'000'000;
+        const auto expected = calc_hits_checkpointed(N, 3, 665, file, std::chrono::seconds{10}, nullptr, 1 << 12);
+        REQUIRE(expected);
+        CHECK(!std::filesystem::exists(file));
+
+        std::atomic<bool> stop = true;
+        CHECK(!calc_hits_checkpointed(N, 3, 665, file, std::chrono::seconds{10}, &stop, 1 << 12));
+        REQUIRE(load_checkpoint(file));
+
+        // a run killed part way through: every worker has done some of its samples
+        Checkpoint partial{N, 665, {}};
+        for (auto rnd_gen : make_streams(665, 3))
+        {
+            const uintmax_t done = 1000 * (partial.workers.size() + 1);
+            const uintmax_t hits = count_hits(rnd_gen, done);
+            partial.workers.push_back({done, hits, rnd_gen.state()});
+        }
+        save_checkpoint(file, partial);
+
+        CHECK_THROWS_AS(calc_hits_checkpointed(N + 1, 3, 665, file), std::runtime_error);
+
+        // resumed with a different thread count - the saved worker layout wins
+        CHECK(calc_hits_checkpointed(N, 5, 665, file, std::chrono::seconds{10}, nullptr, 1 << 12) == expected);
+        CHECK(!std::filesystem::exists(file));
+    }
+
+    SECTION("an unwritable checkpoint is an error, not a crash")
+    {
+        CHECK_THROWS_AS(calc_hits_checkpointed(1000, 2, 665, "/nonexistent/pi_tests.checkpoint"), std::runtime_error);
+
+        // the directory goes away while the workers run - the failed save stops them and is rethrown
+        const auto dir = std::filesystem::temp_directory_path() / "pi_tests_checkpoint_dir";
+        std::filesystem::create_directories(dir);
+        std::thread remover{[&] {
+            std::this_thread::sleep_for(std::chrono::milliseconds{100});
+            std::error_code ec; // races with the saver creating its temporary file - retried until it is gone
+            while (std::filesystem::exists(dir))
+                std::filesystem::remove_all(dir, ec);
+        }};
+        CHECK_THROWS_AS(calc_hits_checkpointed(20'000'000'000, 2, 665, dir / "x.checkpoint", std::chrono::milliseconds{20}, nullptr, 1 << 16),
+            std::runtime_error);
+        remover.join();
+    }
+
+    SECTION("a stop request is noticed without waiting for the interval")
+    {
+        std::atomic<bool> stop = false;
+        std::thread stopper{[&] {
+            std::this_thread::sleep_for(std::chrono::milliseconds{100});
+            stop = true;
+        }};
+        const auto start = std::chrono::steady_clock::now();
+        CHECK(!calc_hits_checkpointed(20'000'000'000, 2, 665, file, std::chrono::seconds{60}, &stop, 1 << 16));
+        CHECK(std::chrono::steady_clock::now() - start < std::chrono::seconds{10});
+        stopper.join();
+        std::filesystem::remove(file);
+    }
+}
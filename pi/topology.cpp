@@ -0,0 +1,265 @@
+#include "topology.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <fstream>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <thread>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace
+{
+    std::string read_line(const std::filesystem::path& path)
+    {
+        std::ifstream in{path};
+        std::string line;
+        std::getline(in, line);
+        return line;
+    }
+
+    unsigned read_unsigned(const std::filesystem::path& path, unsigned fallback)
+    {
+        const std::string line = read_line(path);
+        try
+        {
+            return line.empty() ? fallback : static_cast<unsigned>(std::stoul(line));
+        }
+        catch (const std::exception&)
+        {
+            return fallback;
+        }
+    }
+
+    std::atomic<size_t> pin_failures = 0;
+}
+
+CpuTopology::CpuTopology(std::vector<LogicalCpu> cpus)
+    : cpus_{std::move(cpus)}
+{
+    if (cpus_.empty())
+        throw std::invalid_argument("CpuTopology: no cpus");
+
+    std::sort(cpus_.begin(), cpus_.end(), [](const LogicalCpu& a, const LogicalCpu& b) { return a.id < b.id; });
+}
+
+CpuTopology CpuTopology::detect(const std::filesystem::path& sysfs_root)
+{
+    const std::vector<unsigned> online = parse_cpu_list(read_line(sysfs_root / "cpu" / "online"));
+
+    if (online.empty())
+    {
+        std::vector<LogicalCpu> cpus;
+        for (unsigned id = 0; id < std::max(1u, std::thread::hardware_concurrency()); ++id)
+            cpus.push_back({id, id, 0, 0});
+        return CpuTopology{std::move(cpus)};
+    }
+
+    // cpu -> node from node*/cpulist; kernels without NUMA support have no node directory
+    std::map<unsigned, unsigned> node_of;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(sysfs_root / "node", ec))
+    {
+        const std::string name = entry.path().filename().string();
+        if (name.rfind("node", 0) != 0 || name.size() == 4 || !std::isdigit(static_cast<unsigned char>(name[4])))
+            continue;
+
+        const unsigned node = static_cast<unsigned>(std::stoul(name.substr(4)));
+        for (unsigned cpu : parse_cpu_list(read_line(entry.path() / "cpulist")))
+            node_of[cpu] = node;
+    }
+
+    std::vector<LogicalCpu> cpus;
+    for (unsigned id : online)
+    {
+        const auto topology = sysfs_root / "cpu" / ("cpu" + std::to_string(id)) / "topology";
+        const auto node = node_of.find(id);
+
+        cpus.push_back({id, read_unsigned(topology / "core_id", id), read_unsigned(topology / "physical_package_id", 0),
+            (node != node_of.end()) ? node->second : 0});
+    }
+
+    return CpuTopology{std::move(cpus)};
+}
+
+CpuTopology CpuTopology::restricted_to(const std::vector<unsigned>& allowed) const
+{
+    std::vector<LogicalCpu> cpus;
+    for (const auto& cpu : cpus_)
+        if (std::find(allowed.begin(), allowed.end(), cpu.id) != allowed.end())
+            cpus.push_back(cpu);
+
+    return cpus.empty() ? *this : CpuTopology{std::move(cpus)};
+}
+
+size_t CpuTopology::no_of_nodes() const
+{
+    std::set<unsigned> nodes;
+    for (const auto& cpu : cpus_)
+        nodes.insert(cpu.node);
+    return nodes.size();
+}
+
+size_t CpuTopology::no_of_cores() const
+{
+    std::set<std::pair<unsigned, unsigned>> cores;
+    for (const auto& cpu : cpus_)
+        cores.insert({cpu.package, cpu.core});
+    return cores.size();
+}
+
+std::vector<unsigned> parse_cpu_list(std::string_view text)
+{
+    std::vector<unsigned> cpus;
+
+    while (!text.empty())
+    {
+        const size_t comma = text.find(',');
+        std::string_view range = text.substr(0, comma);
+        text = (comma == std::string_view::npos) ? std::string_view{} : text.substr(comma + 1);
+
+        while (!range.empty() && std::isspace(static_cast<unsigned char>(range.back())))
+            range.remove_suffix(1);
+        if (range.empty())
+            continue;
+
+        const size_t dash = range.find('-');
+        const unsigned first = static_cast<unsigned>(std::stoul(std::string{range.substr(0, dash)}));
+        const unsigned last = (dash == std::string_view::npos) ? first : static_cast<unsigned>(std::stoul(std::string{range.substr(dash + 1)}));
+
+        for (unsigned cpu = first; cpu <= last; ++cpu)
+            cpus.push_back(cpu);
+    }
+
+    return cpus;
+}
+
+std::string to_string(Placement placement)
+{
+    switch (placement)
+    {
+    case Placement::none:
+        return "none";
+    case Placement::compact:
+        return "compact";
+    case Placement::spread:
+        return "spread";
+    }
+    return "unknown";
+}
+
+Placement placement_from_string(std::string_view text)
+{
+    for (Placement placement : {Placement::none, Placement::compact, Placement::spread})
+        if (text == to_string(placement))
+            return placement;
+
+    throw std::invalid_argument("unknown placement " + std::string{text});
+}
+
+std::vector<unsigned> assign_cpus(const CpuTopology& topology, Placement placement, size_t no_of_threads)
+{
+    if (placement == Placement::none || no_of_threads == 0)
+        return {};
+
+    // per node: first hardware thread of every core, then the second one, ...
+    std::map<unsigned, std::vector<unsigned>> node_cpus;
+    {
+        std::map<unsigned, std::map<std::pair<unsigned, unsigned>, std::vector<unsigned>>> cores; // node -> core -> cpus
+        for (const auto& cpu : topology.cpus())
+            cores[cpu.node][{cpu.package, cpu.core}].push_back(cpu.id);
+
+        for (auto& [node, node_cores] : cores)
+            for (size_t smt = 0;; ++smt)
+            {
+                bool any = false;
+                for (auto& [core, siblings] : node_cores)
+                    if (smt < siblings.size())
+                    {
+                        node_cpus[node].push_back(siblings[smt]);
+                        any = true;
+                    }
+                if (!any)
+                    break;
+            }
+    }
+
+    std::vector<unsigned> order;
+    if (placement == Placement::compact)
+    {
+        for (const auto& [node, cpus] : node_cpus)
+            order.insert(order.end(), cpus.begin(), cpus.end());
+    }
+    else
+    {
+        for (size_t i = 0; order.size() < topology.cpus().size(); ++i)
+            for (const auto& [node, cpus] : node_cpus)
+                if (i < cpus.size())
+                    order.push_back(cpus[i]);
+    }
+
+    std::vector<unsigned> assigned(no_of_threads);
+    for (size_t i = 0; i < no_of_threads; ++i)
+        assigned[i] = order[i % order.size()];
+
+    return assigned;
+}
+
+std::vector<unsigned> current_affinity()
+{
+    std::vector<unsigned> cpus;
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (pthread_getaffinity_np(pthread_self(), sizeof(set), &set) == 0)
+        for (unsigned cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+            if (CPU_ISSET(cpu, &set))
+                cpus.push_back(cpu);
+#endif
+    return cpus;
+}
+
+bool set_affinity(const std::vector<unsigned>& cpus)
+{
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (unsigned cpu : cpus)
+        if (cpu < CPU_SETSIZE)
+            CPU_SET(cpu, &set);
+    return !cpus.empty() && pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpus;
+    return false;
+#endif
+}
+
+ScopedPin::ScopedPin(const std::vector<unsigned>& cpus, size_t worker_id)
+{
+    if (cpus.empty())
+        return;
+
+    std::vector<unsigned> previous = current_affinity();
+    pinned_ = pin_current_thread(cpus[worker_id % cpus.size()]);
+    if (pinned_)
+        previous_ = std::move(previous);
+    else
+        ++pin_failures;
+}
+
+ScopedPin::~ScopedPin()
+{
+    if (!previous_.empty())
+        set_affinity(previous_);
+}
+
+size_t ScopedPin::no_of_failures()
+{
+    return pin_failures;
+}
@@ -0,0 +1,89 @@
+#ifndef TOPOLOGY_HPP
+#define TOPOLOGY_HPP
+
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct LogicalCpu
+{
+    unsigned id;
+    unsigned core;    // physical core within the package
+    unsigned package; // socket
+    unsigned node;    // NUMA node
+};
+
+// Online logical CPUs with their core, socket and NUMA node, as reported by Linux sysfs.
+// Falls back to hardware_concurrency CPUs on a single node when sysfs is not available.
+class CpuTopology
+{
+    std::vector<LogicalCpu> cpus_;
+
+public:
+    explicit CpuTopology(std::vector<LogicalCpu> cpus);
+
+    // sysfs_root is a parameter so tests can point it at a fake tree
+    static CpuTopology detect(const std::filesystem::path& sysfs_root = "/sys/devices/system");
+
+    // only the CPUs in allowed (e.g. current_affinity() - a process started under taskset or in a cpuset
+    // may not run on every online CPU); unchanged if allowed is empty or has none of them
+    CpuTopology restricted_to(const std::vector<unsigned>& allowed) const;
+
+    const std::vector<LogicalCpu>& cpus() const { return cpus_; }
+    size_t no_of_nodes() const;
+    size_t no_of_cores() const;
+};
+
+// parses a sysfs cpu list like "0-3,8-11"
+std::vector<unsigned> parse_cpu_list(std::string_view text);
+
+enum class Placement
+{
+    none,    // leave it to the scheduler
+    compact, // fill one NUMA node before the next
+    spread   // round-robin over NUMA nodes
+};
+
+std::string to_string(Placement placement);
+Placement placement_from_string(std::string_view text);
+
+// CPU for worker i (i < no_of_threads); empty for Placement::none.
+// Within a node distinct physical cores come before their SMT siblings; workers wrap around
+// when there are more of them than logical CPUs.
+std::vector<unsigned> assign_cpus(const CpuTopology& topology, Placement placement, size_t no_of_threads);
+
+// affinity mask of the calling thread - empty if it cannot be queried (or not Linux)
+std::vector<unsigned> current_affinity();
+
+// restricts the calling thread to the given logical CPUs - false if the OS refused (or not Linux)
+bool set_affinity(const std::vector<unsigned>& cpus);
+
+inline bool pin_current_thread(unsigned cpu)
+{
+    return set_affinity({cpu});
+}
+
+// Pins the calling thread to cpus[worker_id % cpus.size()] and restores its previous affinity
+// on destruction (worker 0 of run_work_stealing is the caller's own thread). No-op for an empty list.
+// A pin the OS refuses leaves the thread unpinned: pinned() is false and no_of_failures() counts it.
+class ScopedPin
+{
+    std::vector<unsigned> previous_;
+    bool pinned_ = false;
+
+public:
+    ScopedPin(const std::vector<unsigned>& cpus, size_t worker_id);
+    ~ScopedPin();
+
+    bool pinned() const { return pinned_; }
+
+    // refused pins in this process so far
+    static size_t no_of_failures();
+
+    ScopedPin(const ScopedPin&) = delete;
+    ScopedPin& operator=(const ScopedPin&) = delete;
+};
+
+#endif
@@ -0,0 +1,106 @@
+#ifndef WORK_STEALING_HPP
+#define WORK_STEALING_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "topology.hpp"
+
+struct SampleBlock
+{
+    uintmax_t first;
+    uintmax_t count;
+};
+
+// owner pops from the back (LIFO - hot in cache), thieves steal from the front
+class WorkStealingDeque
+{
+    std::deque<SampleBlock> blocks_;
+    std::mutex mtx_;
+
+public:
+    void push(const SampleBlock& block)
+    {
+        std::lock_guard lk{mtx_};
+        blocks_.push_back(block);
+    }
+
+    std::optional<SampleBlock> pop()
+    {
+        std::lock_guard lk{mtx_};
+        if (blocks_.empty())
+            return std::nullopt;
+
+        SampleBlock block = blocks_.back();
+        blocks_.pop_back();
+        return block;
+    }
+
+    std::optional<SampleBlock> steal()
+    {
+        std::lock_guard lk{mtx_};
+        if (blocks_.empty())
+            return std::nullopt;
+
+        SampleBlock block = blocks_.front();
+        blocks_.pop_front();
+        return block;
+    }
+};
+
+// Splits [0, total) into blocks of block_size samples (the last one may be shorter),
+// deals them out to per-thread deques and runs block_func(worker_id, block) on every block.
+// A worker that runs out of its own blocks steals from the others, so fast cores
+// end up processing more blocks than slow ones.
+// With a non-empty cpus list (see assign_cpus) worker i is pinned to cpus[i % cpus.size()] while it runs.
+template <typename BlockFunc>
+void run_work_stealing(uintmax_t total, uintmax_t block_size, size_t no_of_threads, BlockFunc block_func,
+    const std::vector<unsigned>& cpus = {})
+{
+    no_of_threads = std::max<size_t>(no_of_threads, 1);
+    block_size = std::max<uintmax_t>(block_size, 1);
+
+    std::vector<WorkStealingDeque> deques(no_of_threads);
+
+    const uintmax_t no_of_blocks = (total + block_size - 1) / block_size;
+    for (uintmax_t b = 0; b < no_of_blocks; ++b)
+    {
+        const uintmax_t first = b * block_size;
+        const size_t owner = static_cast<size_t>(b * no_of_threads / no_of_blocks); // contiguous ranges per worker
+        deques[owner].push(SampleBlock{first, std::min(block_size, total - first)});
+    }
+
+    auto worker = [&](size_t id) {
+        const ScopedPin pin{cpus, id};
+
+        while (true)
+        {
+            std::optional<SampleBlock> block = deques[id].pop();
+
+            for (size_t i = 1; !block && i < no_of_threads; ++i)
+                block = deques[(id + i) % no_of_threads].steal();
+
+            // no new work is ever pushed - if every deque is empty we are done
+            if (!block)
+                return;
+
+            block_func(id, *block);
+        }
+    };
+
+    std::vector<std::thread> thds;
+    for (size_t i = 1; i < no_of_threads; ++i)
+        thds.emplace_back(worker, i);
+
+    worker(0);
+
+    for (auto& thd : thds)
+        thd.join();
+}
+
+#endif
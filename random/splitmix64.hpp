@@ -0,0 +1,40 @@
+#ifndef SPLITMIX64_HPP
+#define SPLITMIX64_HPP
+
+#include <cstdint>
+#include <limits>
+
+// SplitMix64 (Steele, Lea & Flood) - 64 bits of state, one add and three xor-shift-multiplies per number;
+// satisfies UniformRandomBitGenerator, so it can be used with <random> distributions.
+// Shared by the examples: a fast generator on its own (threads) and the seeder of larger states (pi).
+class SplitMix64
+{
+    uint64_t state_;
+
+public:
+    using result_type = uint64_t;
+
+    static constexpr uint64_t gamma = 0x9E3779B97F4A7C15ULL; // added to the state for every number
+
+    explicit SplitMix64(uint64_t seed) : state_{seed} {}
+
+    // stream k starts 2^40 * k numbers after seed in the same Weyl sequence - streams do not overlap
+    // unless one of them draws more than 2^40 numbers
+    static SplitMix64 stream(uint64_t seed, uint64_t k)
+    {
+        return SplitMix64{seed + (k << 40) * gamma};
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    result_type operator()()
+    {
+        uint64_t z = (state_ += gamma);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+};
+
+#endif
@@ -0,0 +1,360 @@
+#ifndef ASYNC_LOGGER_HPP
+#define ASYNC_LOGGER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace async_logger_detail
+{
+	template <typename T>
+	constexpr bool is_string_like = std::is_convertible_v<const T&, std::string_view>;
+
+	// bytes an argument takes in a record, not counting characters of strings (stored as length + chars)
+	template <typename T>
+	constexpr size_t fixed_size()
+	{
+		if constexpr (is_string_like<T>)
+			return sizeof(uint16_t);
+		else
+			return sizeof(T);
+	}
+
+	template <typename T>
+	void encode(std::byte*& pos, size_t& char_budget, const T& arg)
+	{
+		if constexpr (is_string_like<T>)
+		{
+			const std::string_view text{arg};
+			const auto length = static_cast<uint16_t>(std::min({text.size(), char_budget, size_t{UINT16_MAX}}));
+			std::memcpy(pos, &length, sizeof(length));
+			std::memcpy(pos + sizeof(length), text.data(), length);
+			pos += sizeof(length) + length;
+			char_budget -= length;
+		}
+		else
+		{
+			static_assert(std::is_trivially_copyable_v<T>, "log arguments are strings or trivially copyable values");
+			std::memcpy(pos, &arg, sizeof(T));
+			pos += sizeof(T);
+		}
+	}
+
+	template <typename T>
+	void decode(std::ostream& out, const std::byte*& pos)
+	{
+		if constexpr (is_string_like<T>)
+		{
+			uint16_t length;
+			std::memcpy(&length, pos, sizeof(length));
+			out << std::string_view{reinterpret_cast<const char*>(pos + sizeof(length)), length};
+			pos += sizeof(length) + length;
+		}
+		else
+		{
+			T value;
+			std::memcpy(&value, pos, sizeof(T));
+			out << value;
+			pos += sizeof(T);
+		}
+	}
+
+	// instantiated per argument list at the call site, runs on the flusher thread
+	template <typename... Args>
+	void format(std::ostream& out, const std::byte* payload)
+	{
+		if constexpr (sizeof...(Args) > 0)
+			(decode<Args>(out, payload), ...);
+	}
+}
+
+// Asynchronous logger: log() copies its arguments into a fixed-size record of the calling thread's ring buffer
+// and returns - formatting and writing happen on a background thread that drains all rings every flush_interval,
+// orders the records by time stamp and writes them with one call and one flush.
+//
+//   AsyncLogger logger{std::cout};
+//   logger.log("background_work#", id, " - ", c); // ~ tens of ns, no lock, no formatting, no I/O
+//
+// Every thread gets its own single-producer/single-consumer ring of ring_capacity records, so memory is bounded:
+// when a ring is full the record is dropped, counted and reported in the output - log() never blocks.
+// A thread's ring is retired when the thread exits and freed by the flusher once drained, so a long-lived logger
+// used from many short-lived threads holds rings of the live threads only.
+// Strings are copied (truncated to what fits into a record), other arguments must be trivially copyable.
+class AsyncLogger
+{
+public:
+	static constexpr size_t record_size = 256;
+
+private:
+	struct Record
+	{
+		using Formatter = void (*)(std::ostream&, const std::byte*);
+
+		Formatter format;
+		int64_t timestamp; // steady_clock ticks
+		std::byte payload[record_size - sizeof(Formatter) - sizeof(int64_t)];
+	};
+
+	struct Ring
+	{
+		explicit Ring(size_t capacity) : records(capacity), mask{capacity - 1} {}
+
+		std::vector<Record> records;
+		const uint64_t mask;
+
+		alignas(64) std::atomic<uint64_t> head = 0; // next record to write - owned by the producer
+		uint64_t cached_tail = 0;
+		std::atomic<uint64_t> dropped = 0;
+
+		alignas(64) std::atomic<uint64_t> tail = 0; // next record to read - owned by the flusher
+		uint64_t reported_dropped = 0;
+
+		std::atomic<bool> retired = false; // its thread has exited - head does not move any more
+	};
+
+	// the rings one thread writes to, one per logger - retired when the thread exits
+	struct ThreadRings
+	{
+		uint64_t cached_logger_id = 0; // last logger used - its ring without a lookup
+		Ring* cached_ring = nullptr;
+		std::vector<std::pair<uint64_t, std::weak_ptr<Ring>>> rings; // logger id -> ring, expired once the logger is gone
+
+		ThreadRings() = default;
+		ThreadRings(const ThreadRings&) = delete;
+		ThreadRings& operator=(const ThreadRings&) = delete;
+
+		~ThreadRings()
+		{
+			for (const auto& [id, weak] : rings)
+				if (const auto ring = weak.lock())
+					ring->retired.store(true, std::memory_order_release);
+		}
+	};
+
+	inline static std::atomic<uint64_t> next_id_ = 1;
+
+	const uint64_t id_ = next_id_++;
+	std::ostream& out_;
+	const size_t ring_capacity_;
+	const std::chrono::microseconds flush_interval_;
+
+	std::mutex rings_mtx_;
+	std::vector<std::shared_ptr<Ring>> rings_;
+
+	std::mutex mtx_;
+	std::condition_variable cv_wake_;
+	std::condition_variable cv_swept_;
+	bool stop_ = false;
+	size_t flush_waiters_ = 0;
+	uint64_t sweeps_ = 0;
+	std::atomic<uint64_t> written_ = 0;
+	std::atomic<uint64_t> dropped_ = 0;
+
+	std::thread flusher_;
+
+public:
+	explicit AsyncLogger(std::ostream& out, size_t ring_capacity = 4096,
+		std::chrono::microseconds flush_interval = std::chrono::milliseconds{1})
+		: out_{out}, ring_capacity_{std::bit_ceil(std::max<size_t>(ring_capacity, 1))}, flush_interval_{flush_interval}
+	{
+		flusher_ = std::thread{[this] { flush_loop(); }};
+	}
+
+	AsyncLogger(const AsyncLogger&) = delete;
+	AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+	// writes everything logged so far
+	~AsyncLogger()
+	{
+		{
+			std::lock_guard lk{mtx_};
+			stop_ = true;
+		}
+		cv_wake_.notify_one();
+		flusher_.join();
+	}
+
+	// one line made of args written as with out << arg; false if the record was dropped
+	template <typename... Args>
+	bool log(const Args&... args)
+	{
+		using namespace async_logger_detail;
+
+		constexpr size_t fixed = (fixed_size<Args>() + ... + 0);
+		static_assert(fixed <= sizeof(Record::payload), "too many log arguments for one record");
+
+		Ring& ring = ring_of_this_thread();
+
+		const uint64_t head = ring.head.load(std::memory_order_relaxed);
+		if (head - ring.cached_tail == ring.records.size())
+		{
+			ring.cached_tail = ring.tail.load(std::memory_order_acquire);
+			if (head - ring.cached_tail == ring.records.size())
+			{
+				ring.dropped.store(ring.dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+				return false;
+			}
+		}
+
+		Record& record = ring.records[head & ring.mask];
+		record.format = &format<std::conditional_t<is_string_like<Args>, std::string_view, Args>...>;
+		record.timestamp = std::chrono::steady_clock::now().time_since_epoch().count();
+
+		if constexpr (sizeof...(Args) > 0)
+		{
+			std::byte* pos = record.payload;
+			size_t char_budget = sizeof(Record::payload) - fixed;
+			(encode(pos, char_budget, args), ...);
+		}
+
+		ring.head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	// blocks until everything logged before the call has been written
+	void flush()
+	{
+		std::unique_lock lk{mtx_};
+		const uint64_t target = sweeps_ + 2; // a sweep in progress may have missed the latest records
+		++flush_waiters_;
+		cv_wake_.notify_one();
+		cv_swept_.wait(lk, [&] { return sweeps_ >= target; });
+		--flush_waiters_;
+	}
+
+	uint64_t written() const { return written_; }
+
+	uint64_t dropped() const { return dropped_; }
+
+	// rings not freed yet - one per thread that has logged and not exited, plus retired ones waiting for a sweep
+	size_t no_of_rings()
+	{
+		std::lock_guard lk{rings_mtx_};
+		return rings_.size();
+	}
+
+private:
+	Ring& ring_of_this_thread()
+	{
+		thread_local ThreadRings thread_rings;
+		if (thread_rings.cached_logger_id == id_)
+			return *thread_rings.cached_ring;
+
+		// first call on this thread (or another logger used in between); rings of destroyed loggers are forgotten
+		auto& rings = thread_rings.rings;
+		std::erase_if(rings, [](const auto& entry) { return entry.second.expired(); });
+
+		std::shared_ptr<Ring> ring;
+		const auto it = std::find_if(rings.begin(), rings.end(), [this](const auto& entry) { return entry.first == id_; });
+		if (it != rings.end())
+			ring = it->second.lock();
+		else
+		{
+			ring = std::make_shared<Ring>(ring_capacity_);
+			{
+				std::lock_guard lk{rings_mtx_};
+				rings_.push_back(ring);
+			}
+			rings.emplace_back(id_, ring);
+		}
+
+		thread_rings.cached_logger_id = id_;
+		thread_rings.cached_ring = ring.get(); // alive as long as the logger - rings_ frees it only after this thread exits
+		return *ring;
+	}
+
+	void flush_loop()
+	{
+		std::unique_lock lk{mtx_};
+		while (true)
+		{
+			cv_wake_.wait_for(lk, flush_interval_, [this] { return stop_ || flush_waiters_ > 0; });
+			const bool stopping = stop_;
+
+			lk.unlock();
+			sweep();
+			lk.lock();
+
+			++sweeps_;
+			cv_swept_.notify_all();
+
+			if (stopping)
+				break;
+		}
+	}
+
+	void sweep()
+	{
+		std::vector<Ring*> rings;
+		{
+			std::lock_guard lk{rings_mtx_};
+			for (const auto& ring : rings_)
+				rings.push_back(ring.get());
+		}
+
+		std::vector<const Record*> batch;
+		std::vector<uint64_t> heads(rings.size());
+		std::vector<Ring*> drained; // retired before their head was read - everything they hold is in this batch
+		std::ostringstream text;
+
+		for (size_t r = 0; r < rings.size(); ++r)
+		{
+			Ring& ring = *rings[r];
+			if (ring.retired.load(std::memory_order_acquire))
+				drained.push_back(&ring);
+			heads[r] = ring.head.load(std::memory_order_acquire);
+			for (uint64_t i = ring.tail.load(std::memory_order_relaxed); i != heads[r]; ++i)
+				batch.push_back(&ring.records[i & ring.mask]);
+
+			const uint64_t dropped = ring.dropped.load(std::memory_order_relaxed);
+			if (dropped != ring.reported_dropped)
+			{
+				text << "[AsyncLogger] " << dropped - ring.reported_dropped << " records dropped\n";
+				dropped_ += dropped - ring.reported_dropped;
+				ring.reported_dropped = dropped;
+			}
+		}
+
+		std::stable_sort(batch.begin(), batch.end(), [](const Record* a, const Record* b) { return a->timestamp < b->timestamp; });
+
+		for (const Record* record : batch)
+		{
+			record->format(text, record->payload);
+			text << '\n';
+		}
+
+		// records are formatted - the producers may reuse them
+		for (size_t r = 0; r < rings.size(); ++r)
+			rings[r]->tail.store(heads[r], std::memory_order_release);
+
+		const std::string lines = std::move(text).str();
+		if (!lines.empty())
+		{
+			out_.write(lines.data(), static_cast<std::streamsize>(lines.size()));
+			out_.flush();
+		}
+		written_ += batch.size();
+
+		if (!drained.empty())
+		{
+			std::lock_guard lk{rings_mtx_};
+			std::erase_if(rings_, [&](const auto& ring) { return std::find(drained.begin(), drained.end(), ring.get()) != drained.end(); });
+		}
+	}
+};
+
+#endif
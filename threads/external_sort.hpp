@@ -0,0 +1,305 @@
+#ifndef EXTERNAL_SORT_HPP
+#define EXTERNAL_SORT_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "radix_sort.hpp"
+
+// Out-of-core sort of a binary file of native-endian int32 values:
+// 1. the input is read in runs of memory_bytes / 2 (radix_sort needs a second buffer of the run's size),
+//    every run is sorted in memory (parallel radix_sort) and spilled to a temporary file
+// 2. runs are k-way merged through a min-heap, every run read through its own io_buffer_bytes buffer;
+//    with more runs than fit into memory next to the output buffer ((memory_bytes - io_buffer_bytes) / io_buffer_bytes),
+//    groups of runs are merged into longer runs first
+struct ExternalSortOptions
+{
+	size_t memory_bytes = size_t{256} << 20;
+	size_t io_buffer_bytes = size_t{4} << 20;
+	size_t no_of_threads = std::max(1u, std::thread::hardware_concurrency());
+	std::filesystem::path temp_dir = std::filesystem::temp_directory_path();
+};
+
+struct ExternalSortStats
+{
+	uint64_t elements = 0;
+	size_t runs = 0;
+	size_t merge_passes = 0;
+	double run_seconds = 0;
+	double merge_seconds = 0;
+
+	double seconds() const { return run_seconds + merge_seconds; }
+
+	// input size over total time
+	double mb_per_second() const
+	{
+		return (seconds() > 0) ? static_cast<double>(elements * sizeof(int32_t)) / (1 << 20) / seconds() : 0.0;
+	}
+};
+
+namespace external_sort_detail
+{
+	using Value = int32_t;
+
+	struct FileCloser
+	{
+		void operator()(std::FILE* f) const { std::fclose(f); }
+	};
+
+	using File = std::unique_ptr<std::FILE, FileCloser>;
+
+	inline File open_file(const std::filesystem::path& path, const char* mode)
+	{
+		File file{std::fopen(path.string().c_str(), mode)};
+		if (!file)
+			throw std::runtime_error("cannot open " + path.string());
+		return file;
+	}
+
+	// closes a file that was written - the last stdio flush may fail (ENOSPC, EIO), which FileCloser cannot report
+	inline void close_file(File& file, const std::filesystem::path& path)
+	{
+		const bool flushed = std::fflush(file.get()) == 0;
+		const bool closed = std::fclose(file.release()) == 0;
+		if (!flushed || !closed)
+			throw std::runtime_error("write failed: " + path.string());
+	}
+
+	// temporary run file, removed when the last owner goes away
+	class TempFile
+	{
+		std::filesystem::path path_;
+
+	public:
+		explicit TempFile(const std::filesystem::path& dir)
+		{
+			static std::atomic<uint64_t> counter = 0;
+			const auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+			path_ = dir / ("external_sort_" + std::to_string(stamp) + "_" + std::to_string(counter++) + ".run");
+		}
+
+		TempFile(const TempFile&) = delete;
+		TempFile& operator=(const TempFile&) = delete;
+
+		~TempFile()
+		{
+			std::error_code ec;
+			std::filesystem::remove(path_, ec);
+		}
+
+		const std::filesystem::path& path() const { return path_; }
+	};
+
+	class BufferedReader
+	{
+		File file_;
+		std::vector<Value> buffer_;
+		size_t pos_ = 0;
+		size_t size_ = 0;
+
+	public:
+		BufferedReader(const std::filesystem::path& path, size_t buffer_elements)
+			: file_{open_file(path, "rb")}, buffer_(std::max<size_t>(buffer_elements, 1))
+		{
+		}
+
+		bool next(Value& value)
+		{
+			if (pos_ == size_)
+			{
+				size_ = std::fread(buffer_.data(), sizeof(Value), buffer_.size(), file_.get());
+				pos_ = 0;
+				if (size_ == 0)
+				{
+					if (std::ferror(file_.get()))
+						throw std::runtime_error("read failed");
+					return false;
+				}
+			}
+
+			value = buffer_[pos_++];
+			return true;
+		}
+	};
+
+	// finish() writes the rest and closes the file, throwing on any error; without it the destructor
+	// writes what it can, unchecked (unwinding after another error)
+	class BufferedWriter
+	{
+		std::filesystem::path path_;
+		File file_;
+		std::vector<Value> buffer_;
+		size_t size_ = 0;
+
+	public:
+		BufferedWriter(const std::filesystem::path& path, size_t buffer_elements)
+			: path_{path}, file_{open_file(path, "wb")}, buffer_(std::max<size_t>(buffer_elements, 1))
+		{
+		}
+
+		void write(Value value)
+		{
+			buffer_[size_++] = value;
+			if (size_ == buffer_.size())
+				flush();
+		}
+
+		void flush()
+		{
+			if (std::fwrite(buffer_.data(), sizeof(Value), size_, file_.get()) != size_)
+				throw std::runtime_error("write failed: " + path_.string());
+			size_ = 0;
+		}
+
+		void finish()
+		{
+			flush();
+			close_file(file_, path_);
+		}
+
+		~BufferedWriter()
+		{
+			if (file_ && size_ > 0)
+				std::fwrite(buffer_.data(), sizeof(Value), size_, file_.get());
+		}
+	};
+
+	inline void merge(const std::vector<std::filesystem::path>& inputs, const std::filesystem::path& output, size_t buffer_elements)
+	{
+		std::vector<BufferedReader> readers;
+		readers.reserve(inputs.size());
+		for (const auto& input : inputs)
+			readers.emplace_back(input, buffer_elements);
+
+		using Head = std::pair<Value, size_t>; // value, reader - ties go to the earlier run
+		std::priority_queue<Head, std::vector<Head>, std::greater<>> heap;
+
+		for (size_t r = 0; r < readers.size(); ++r)
+			if (Value v; readers[r].next(v))
+				heap.push({v, r});
+
+		BufferedWriter writer{output, buffer_elements};
+		while (!heap.empty())
+		{
+			const auto [value, r] = heap.top();
+			heap.pop();
+			writer.write(value);
+
+			if (Value v; readers[r].next(v))
+				heap.push({v, r});
+		}
+		writer.finish();
+	}
+}
+
+inline ExternalSortStats external_sort(const std::filesystem::path& input, const std::filesystem::path& output,
+	const ExternalSortOptions& options = {})
+{
+	using namespace external_sort_detail;
+
+	const auto file_size = std::filesystem::file_size(input);
+	if (file_size % sizeof(Value) != 0)
+		throw std::runtime_error(input.string() + ": size is not a multiple of " + std::to_string(sizeof(Value)) + " bytes");
+
+	// peak memory stays within memory_bytes: a run and radix_sort's scratch copy of it, or fan_in input buffers and the output buffer
+	const size_t io_buffer_bytes = std::max<size_t>(options.io_buffer_bytes, 1);
+	const size_t run_elements = std::max<size_t>(options.memory_bytes / (2 * sizeof(Value)), 1);
+	const size_t buffer_elements = std::max<size_t>(io_buffer_bytes / sizeof(Value), 1);
+	const size_t fan_in = std::max<size_t>((options.memory_bytes - std::min(options.memory_bytes, io_buffer_bytes)) / io_buffer_bytes, 2);
+
+	ExternalSortStats stats;
+	stats.elements = file_size / sizeof(Value);
+
+	// phase 1 - sorted runs
+	auto start = std::chrono::steady_clock::now();
+
+	std::vector<std::shared_ptr<TempFile>> runs;
+	{
+		File in = open_file(input, "rb");
+		std::vector<Value> run(std::min<uint64_t>(run_elements, stats.elements));
+
+		while (true)
+		{
+			const size_t count = std::fread(run.data(), sizeof(Value), run.size(), in.get());
+			if (count < run.size() && std::ferror(in.get()))
+				throw std::runtime_error("read failed: " + input.string());
+			if (count == 0)
+				break;
+
+			run.resize(count);
+			radix_sort(run, options.no_of_threads);
+
+			// one run only - straight to the output
+			if (runs.empty() && count == stats.elements)
+			{
+				File out = open_file(output, "wb");
+				if (std::fwrite(run.data(), sizeof(Value), count, out.get()) != count)
+					throw std::runtime_error("write failed: " + output.string());
+				close_file(out, output);
+				stats.runs = 1;
+				stats.run_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+				return stats;
+			}
+
+			auto file = std::make_shared<TempFile>(options.temp_dir);
+			File out = open_file(file->path(), "wb");
+			if (std::fwrite(run.data(), sizeof(Value), count, out.get()) != count)
+				throw std::runtime_error("write failed: " + file->path().string());
+			close_file(out, file->path());
+			runs.push_back(std::move(file));
+		}
+	}
+
+	stats.runs = runs.size();
+	stats.run_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	// phase 2 - merge passes until one group of runs remains
+	start = std::chrono::steady_clock::now();
+
+	if (runs.empty())
+	{
+		File out = open_file(output, "wb"); // empty input
+		close_file(out, output);
+	}
+	else
+	{
+		while (runs.size() > fan_in)
+		{
+			std::vector<std::shared_ptr<TempFile>> merged;
+			for (size_t first = 0; first < runs.size(); first += fan_in)
+			{
+				std::vector<std::filesystem::path> group;
+				for (size_t r = first; r < std::min(first + fan_in, runs.size()); ++r)
+					group.push_back(runs[r]->path());
+
+				auto file = std::make_shared<TempFile>(options.temp_dir);
+				merge(group, file->path(), buffer_elements);
+				merged.push_back(std::move(file));
+			}
+
+			runs = std::move(merged); // previous runs are deleted here
+			++stats.merge_passes;
+		}
+
+		std::vector<std::filesystem::path> last;
+		for (const auto& run : runs)
+			last.push_back(run->path());
+		merge(last, output, buffer_elements);
+		++stats.merge_passes;
+	}
+
+	stats.merge_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return stats;
+}
+
+#endif
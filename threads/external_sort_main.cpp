@@ -0,0 +1,75 @@
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "external_sort.hpp"
+
+void print_usage(std::ostream& out)
+{
+	out << "Usage: threads_external_sort INPUT OUTPUT [options]\n"
+		<< "       threads_external_sort --generate COUNT FILE   (random ints from [0, 1e6])\n"
+		<< "  --memory MB      memory budget - runs are half of it, radix sort needs the other half (default 256)\n"
+		<< "  --buffer KB      I/O buffer per merged run and for the output (default 4096)\n"
+		<< "  --threads T      threads sorting each run (default hardware_concurrency)\n"
+		<< "  --tmp DIR        directory for run files (default system temp)\n";
+}
+
+void generate(uint64_t count, const std::filesystem::path& file)
+{
+	std::mt19937_64 rnd_gen{std::random_device{}()};
+	std::uniform_int_distribution<int32_t> rnd_distr(0, 1'000'000);
+
+	external_sort_detail::BufferedWriter writer{file, 1 << 20};
+	for (uint64_t i = 0; i < count; ++i)
+		writer.write(rnd_distr(rnd_gen));
+	writer.finish();
+}
+
+int main(int argc, char* argv[])
+{
+	try
+	{
+		if (argc == 4 && std::string{argv[1]} == "--generate")
+		{
+			generate(std::stoull(argv[2]), argv[3]);
+			return 0;
+		}
+
+		if (argc < 3 || argc % 2 == 0)
+		{
+			print_usage(std::cerr);
+			return 1;
+		}
+
+		ExternalSortOptions options;
+		for (int i = 3; i + 1 < argc; i += 2)
+		{
+			const std::string arg = argv[i];
+			const std::string value = argv[i + 1];
+
+			if (arg == "--memory")
+				options.memory_bytes = std::stoull(value) << 20;
+			else if (arg == "--buffer")
+				options.io_buffer_bytes = std::stoull(value) << 10;
+			else if (arg == "--threads")
+				options.no_of_threads = std::stoul(value);
+			else if (arg == "--tmp")
+				options.temp_dir = value;
+			else
+				throw std::invalid_argument("unknown option " + arg);
+		}
+
+		const ExternalSortStats stats = external_sort(argv[1], argv[2], options);
+
+		std::cout << stats.elements << " ints, " << stats.runs << " runs, " << stats.merge_passes << " merge passes\n"
+				  << "runs: " << stats.run_seconds << "s, merge: " << stats.merge_seconds << "s, total: " << stats.seconds() << "s\n"
+				  << "throughput: " << stats.mb_per_second() << " MB/s\n";
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << "Error: " << e.what() << "\n";
+		return 1;
+	}
+}
@@ -0,0 +1,69 @@
+#ifndef JOBS_HPP
+#define JOBS_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Sleeps for duration unless a stop is requested first - the stop callback of the condition_variable_any
+// wakes the sleeper immediately. Returns false when the sleep was cut short by a stop request.
+template <typename Rep, typename Period>
+bool interruptible_sleep_for(std::stop_token stop, const std::chrono::duration<Rep, Period>& duration)
+{
+	std::mutex mtx;
+	std::condition_variable_any cv;
+	std::unique_lock lk{mtx};
+	cv.wait_for(lk, stop, duration, [] { return false; });
+
+	return !stop.stop_requested();
+}
+
+// Owns long-running jobs run on std::jthreads - nothing is detached, nothing outlives the group.
+// A job taking a std::stop_token as its first parameter gets the token of its thread and is expected to poll it
+// (or sleep with interruptible_sleep_for) to finish early.
+class JobGroup
+{
+	std::vector<std::jthread> jobs_;
+
+public:
+	JobGroup() = default;
+	JobGroup(const JobGroup&) = delete;
+	JobGroup& operator=(const JobGroup&) = delete;
+
+	// stops all jobs before joining any - destroying the jthreads one by one would wait for every job in turn
+	~JobGroup()
+	{
+		request_stop();
+		join();
+	}
+
+	template <typename F, typename... Args>
+	void spawn(F&& f, Args&&... args)
+	{
+		jobs_.emplace_back(std::forward<F>(f), std::forward<Args>(args)...);
+	}
+
+	void request_stop()
+	{
+		for (auto& job : jobs_)
+			job.request_stop();
+	}
+
+	void join()
+	{
+		for (auto& job : jobs_)
+			if (job.joinable())
+				job.join();
+	}
+
+	size_t size() const
+	{
+		return jobs_.size();
+	}
+};
+
+#endif
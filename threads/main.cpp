@@ -4,52 +4,71 @@
 #include <random>
 #include <algorithm>
 #include <execution>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <vector>
 
-void background_work(int id, const std::string& text)
+#include "async_logger.hpp"
+#include "bench.hpp"
+#include "jobs.hpp"
+#include "parallel_for.hpp"
+#include "pipeline.hpp"
+#include "pixel_pipeline.hpp"
+#include "radix_sort.hpp"
+#include "random_fill.hpp"
+#include "selection.hpp"
+#include "thread_pool.hpp"
+
+AsyncLogger logger{std::cout};
+
+void background_work(std::stop_token stop, int id, const std::string& text)
 {
-	std::cout << "background_work#" << id << " started..." << std::endl;
+	logger.log("background_work#", id, " started...");
 
 	for (const auto& c : text)
 	{
-		std::cout << "background_work#" << id << " - " << c << std::endl;
+		logger.log("background_work#", id, " - ", c);
 
 		std::random_device rd;
 		auto interval = std::chrono::milliseconds(rd() % 1000 + 100);
-		std::this_thread::sleep_for(interval);
+		if (!interruptible_sleep_for(stop, interval))
+		{
+			logger.log("background_work#", id, " cancelled...");
+			return;
+		}
 	}
 
-	std::cout << "background_work#" << id << " finished..." << std::endl;
+	logger.log("background_work#", id, " finished...");
 }
 
-void run_job(const std::string& text)
+std::future<void> run_job(ThreadPool& pool, const std::string& text, std::stop_token stop)
 {
-	std::thread thd{&background_work, 3, text};
-	thd.detach();
+	return pool.submit(&background_work, stop, 3, text);
 }
 
-template<typename Func>
-auto benchmark(Func test_func, int iterations)
+int main(int argc, char* argv[])
 {
-	const auto start = std::chrono::system_clock::now();
-	while (iterations-- > 0)
-		test_func();
-	const auto stop = std::chrono::system_clock::now();
-	const auto secs = std::chrono::duration<double>(stop - start);
-	return secs.count();
-}
+	// --json FILE - benchmark results as JSON (stdout is shared with the demo output)
+	const std::string json_file = (argc > 2 && std::string{argv[1]} == "--json") ? argv[2] : "";
+	std::vector<bench::Result> results;
 
-int main()
-{
 	std::thread thd_empty;
 	std::cout << thd_empty.get_id() << "\n";
 	
 	{
-		std::thread thd_1{&background_work, 1, "THREAD1"};
-		std::thread thd_2{[] { background_work(2, "THREAD2"); }};
-		run_job("JOB!!!!!!!!!!!!!!!!!!!");
+		ThreadPool pool{2};
+
+		std::stop_source job_stop;
+
+		std::jthread thd_1{&background_work, 1, "THREAD1"}; // gets the stop_token of the jthread as first argument
+		std::jthread thd_2{[](std::stop_token stop) { background_work(stop, 2, "THREAD2"); }};
+		std::future<void> job = run_job(pool, "JOB!!!!!!!!!!!!!!!!!!!", job_stop.get_token());
 
 
-		std::vector<std::thread> thds;
+		std::vector<std::jthread> thds;
 		thds.push_back(std::move(thd_1));
 		thds.push_back(std::move(thd_2));
 
@@ -58,6 +77,98 @@ int main()
 			if (thd.joinable())
 				thd.join();
 		}
+
+		job_stop.request_stop(); // the job outlasts the threads - cancelled instead of waited for
+		job.get(); // rethrows if background_work threw
+	}
+
+	logger.flush();
+
+	std::cout << "---------------------------------" << std::endl;
+
+	{
+		// per-task overhead: a thread created and joined for every task vs. tasks queued to a running pool
+		constexpr int batch_size = 1'000;
+		int counter = 0;
+		auto tiny_task = [&counter] { ++counter; };
+
+		ThreadPool pool{1};
+
+		results.push_back(bench::run("std::thread per task", [&] { std::thread{tiny_task}.join(); }));
+		results.push_back(bench::run("pool submit + get", [&] { pool.submit(tiny_task).get(); }));
+		results.push_back(bench::run("pool batch of 1000 tasks", [&] {
+			std::vector<std::future<void>> futures;
+			futures.reserve(batch_size);
+			for (int i = 0; i < batch_size; ++i)
+				futures.push_back(pool.submit(tiny_task));
+			for (auto& f : futures)
+				f.get();
+		}));
+		bench::do_not_optimize(counter);
+	}
+
+	std::cout << "---------------------------------" << std::endl;
+
+	{
+		// shutdown latency: 1000 jobs sleeping in 10 s steps - time from the stop request until all are joined
+		constexpr int no_of_jobs = 1'000;
+		std::atomic<int> sleeping = 0;
+
+		JobGroup jobs;
+		for (int i = 0; i < no_of_jobs; ++i)
+			jobs.spawn([&sleeping](std::stop_token stop) {
+				++sleeping;
+				while (interruptible_sleep_for(stop, std::chrono::seconds{10}))
+				{
+				}
+			});
+
+		while (sleeping < no_of_jobs)
+			std::this_thread::yield();
+		std::this_thread::sleep_for(std::chrono::milliseconds{10}); // the last ones reach their wait
+
+		const double latency = bench::time_once([&] {
+			jobs.request_stop();
+			jobs.join();
+		});
+		results.push_back(bench::analyze("stop + join of 1000 sleeping jobs", {latency}));
+	}
+
+	std::cout << "---------------------------------" << std::endl;
+
+	{
+		// hot-path cost of one log line: a locked stream write ended with std::endl vs. AsyncLogger::log
+		const auto log_file = std::filesystem::temp_directory_path() / "threads_log_bench.txt";
+		int id = 1;
+
+		{
+			std::ofstream out{log_file};
+			std::mutex mtx_out;
+			results.push_back(bench::run("std::ofstream << ... << std::endl (locked)", [&] {
+				std::lock_guard lk{mtx_out};
+				out << "background_work#" << id << " - " << 'x' << std::endl;
+			}));
+		}
+
+		{
+			std::ofstream out{log_file};
+			// samples of batches that fit into the ring - a flush between them, so no record is dropped
+			constexpr int batch_size = 1 << 10;
+			AsyncLogger file_logger{out, batch_size};
+			std::vector<double> samples;
+			for (int s = 0; s < 200; ++s)
+			{
+				samples.push_back(bench::time_once([&] {
+					for (int i = 0; i < batch_size; ++i)
+						file_logger.log("background_work#", id, " - ", 'x');
+				}) / batch_size);
+				file_logger.flush();
+			}
+			results.push_back(bench::analyze("AsyncLogger::log", std::move(samples), batch_size));
+			std::cout << "AsyncLogger: " << file_logger.written() << " records written, " << file_logger.dropped() << " dropped\n";
+		}
+
+		std::filesystem::remove(log_file);
 	}
 
 	std::cout << "---------------------------------" << std::endl;
@@ -65,20 +176,195 @@ int main()
 	std::vector<int> vec(1'000'000);
 
 	std::random_device rd;
-	std::mt19937_64 rnd_gen{rd()};
-	std::uniform_int_distribution<> rnd_distr(0, 1'000'000);
+	const uint64_t seed = (static_cast<uint64_t>(rd()) << 32) | rd();
+
+	{
+		// input generation: one mt19937_64 + uniform_int_distribution vs. a SplitMix64 stream per chunk + Lemire's method
+		std::mt19937_64 rnd_gen{seed};
+		std::uniform_int_distribution<> rnd_distr(0, 1'000'000);
 
-	std::generate(vec.begin(), vec.end(), [&] { return rnd_distr(rnd_gen); });
+		results.push_back(bench::run("std::generate(mt19937_64, uniform_int_distribution)", [&] {
+			std::generate(vec.begin(), vec.end(), [&] { return rnd_distr(rnd_gen); });
+			bench::do_not_optimize(vec.data());
+		}));
+		results.push_back(bench::run("parallel_fill_uniform", [&] {
+			parallel_fill_uniform(vec, 0, 1'000'000, seed);
+			bench::do_not_optimize(vec.data());
+		}));
 
-	auto t1 = benchmark([vec = vec]() mutable { std::sort(vec.begin(), vec.end()) ; }, 1);
-	auto t2 = benchmark([vec = vec]() mutable { std::sort(std::execution::par_unseq, vec.begin(), vec.end()); }, 1);
+		// inputs of hundreds of millions of elements - one run each
+		std::vector<int> big(200'000'000);
+		const double serial = bench::time_once([&] { std::generate(big.begin(), big.end(), [&] { return rnd_distr(rnd_gen); }); });
+		const double parallel = bench::time_once([&] { parallel_fill_uniform(big, 0, 1'000'000, seed); });
+		results.push_back(bench::analyze("std::generate(mt19937_64, uniform_int_distribution) - 200M", {serial}));
+		results.push_back(bench::analyze("parallel_fill_uniform - 200M", {parallel}));
+	}
 
-	std::transform(std::execution::par_unseq, 
-		vec.begin(), vec.end(), vec.begin(), [](int pixel) {
-			return (pixel < 10'000) ? 0 : pixel;
-		});
-	
-	std::cout << "Time sort1: " << t1 << "\n";
-	std::cout << "Time sort2: " << t2 << "\n";
+	// every iteration sorts a fresh copy - the copy is measured separately
+	results.push_back(bench::run("copy", [&] { auto v = vec; bench::do_not_optimize(v.data()); }));
+	results.push_back(bench::run("copy + sort", [&] {
+		auto v = vec;
+		std::sort(v.begin(), v.end());
+		bench::do_not_optimize(v.data());
+	}));
+	results.push_back(bench::run("copy + sort(par_unseq)", [&] {
+		auto v = vec;
+		std::sort(std::execution::par_unseq, v.begin(), v.end());
+		bench::do_not_optimize(v.data());
+	}));
+	results.push_back(bench::run("copy + radix_sort", [&] {
+		auto v = vec;
+		radix_sort(v);
+		bench::do_not_optimize(v.data());
+	}));
+
+	{
+		// jobs that need the top 1000 or the median - selection vs. the full sorts above
+		constexpr size_t k = 1'000;
+		const size_t median = vec.size() / 2;
+
+		results.push_back(bench::run("parallel_top_k(1000)", [&] {
+			auto top = parallel_top_k(vec, k);
+			bench::do_not_optimize(top.data());
+		}));
+		results.push_back(bench::run("copy + parallel_partial_sort(1000)", [&] {
+			auto v = vec;
+			parallel_partial_sort(v, k);
+			bench::do_not_optimize(v.data());
+		}));
+		results.push_back(bench::run("copy + std::nth_element(median)", [&] {
+			auto v = vec;
+			std::nth_element(v.begin(), v.begin() + median, v.end());
+			bench::do_not_optimize(v.data());
+		}));
+		results.push_back(bench::run("copy + parallel_nth_element(median)", [&] {
+			auto v = vec;
+			parallel_nth_element(v, median);
+			bench::do_not_optimize(v.data());
+		}));
+
+		// 20M ints - one run each (the copy is included in none of them)
+		std::vector<int> big(20'000'000);
+		parallel_fill_uniform(big, 0, 1'000'000'000, seed);
+
+		auto time_on_copy = [&](const std::string& name, auto algorithm) {
+			auto v = big;
+			results.push_back(bench::analyze(name + " - 20M", {bench::time_once([&] { algorithm(v); })}));
+		};
+		time_on_copy("sort(par_unseq)", [](auto& v) { std::sort(std::execution::par_unseq, v.begin(), v.end()); });
+		time_on_copy("parallel_top_k(1000)", [&](auto& v) { bench::do_not_optimize(parallel_top_k(v, k).data()); });
+		time_on_copy("parallel_partial_sort(1000)", [&](auto& v) { parallel_partial_sort(v, k); });
+		time_on_copy("parallel_nth_element(median)", [](auto& v) { parallel_nth_element(v, v.size() / 2); });
+	}
+
+	std::cout << "---------------------------------" << std::endl;
+
+	{
+		// generate -> threshold -> sort of 64 chunks of 64K ints: whole-data phases (each one parallel) vs. chunks
+		// flowing through a pipeline, where the phases overlap and every chunk is sorted while still in cache
+		constexpr size_t chunk_size = 1 << 16;
+		constexpr size_t no_of_chunks = 64;
+		const size_t no_of_threads = std::max(1u, std::thread::hardware_concurrency());
+		const pixel::Threshold threshold{10'000};
+
+		bench::Options options;
+		options.samples = 5;
+
+		results.push_back(bench::run("phases: generate, threshold, sort chunks", [&] {
+			std::vector<int> data(chunk_size * no_of_chunks);
+			parallel_fill_uniform(data, 0, 1'000'000, seed);
+			std::transform(std::execution::par_unseq, data.begin(), data.end(), data.begin(), threshold);
+			parallel_for_threads(no_of_threads, [&](size_t t) {
+				for (size_t c = t; c < no_of_chunks; c += no_of_threads)
+					std::sort(data.begin() + c * chunk_size, data.begin() + (c + 1) * chunk_size);
+			});
+			bench::do_not_optimize(data.data());
+		}, options));
+
+		using Chunk = std::pair<size_t, std::vector<int>>; // index, values
+		const BoundedIntDistribution<int> distr{0, 1'000'000};
+		pipeline::Stats stats;
+
+		results.push_back(bench::run("pipeline: generate | threshold | sort", [&] {
+			std::vector<std::vector<int>> sorted_chunks(no_of_chunks);
+
+			pipeline::Builder builder{8};
+			builder.source("generate chunk", 1, [&](size_t i) -> std::optional<Chunk> {
+					if (i >= no_of_chunks)
+						return std::nullopt;
+
+					Chunk chunk{i, std::vector<int>(chunk_size)};
+					SplitMix64 rnd_gen = SplitMix64::stream(seed, i);
+					for (auto& x : chunk.second)
+						x = distr(rnd_gen);
+					return chunk;
+				})
+				.then("threshold chunk", 1, [&](Chunk chunk) {
+					std::transform(chunk.second.begin(), chunk.second.end(), chunk.second.begin(), threshold);
+					return chunk;
+				})
+				.sink("sort chunk", no_of_threads, [&](Chunk chunk) {
+					std::sort(chunk.second.begin(), chunk.second.end());
+					sorted_chunks[chunk.first] = std::move(chunk.second);
+				});
+
+			stats = builder.run();
+			bench::do_not_optimize(sorted_chunks.data());
+		}, options));
+
+		std::cout << stats;
+	}
+
+	std::cout << "---------------------------------" << std::endl;
+
+	{
+		// threshold -> clamp -> scale -> histogram over a 4096x4096 image:
+		// chained passes move the image through memory 7 times (3 x read + write, 1 x read - the stage-free pipeline
+		// run in place only reads), the fused pipeline twice
+		const pixel::Threshold threshold{10'000};
+		const pixel::Clamp clamp{0, 900'000};
+		const pixel::Scale scale{0.25f};
+		const pixel::Pipeline fused{threshold, clamp, scale};
+
+		std::vector<int> image(4096 * 4096);
+		for (size_t i = 0; i < image.size(); ++i)
+			image[i] = vec[i % vec.size()];
+		std::vector<int> output(image.size());
+		pixel::Histogram histogram{0, 250'000, 256};
+
+		const double image_bytes = static_cast<double>(image.size() * sizeof(int));
+		const std::pair<const char*, double> traffic[] = {{"chained std::transform(par_unseq)", 7 * image_bytes}, {"fused pipeline", 2 * image_bytes}};
+
+		bench::Options options;
+		options.samples = 10;
+
+		results.push_back(bench::run(traffic[0].first, [&] {
+			std::transform(std::execution::par_unseq, image.begin(), image.end(), output.begin(), threshold);
+			std::transform(std::execution::par_unseq, output.begin(), output.end(), output.begin(), clamp);
+			std::transform(std::execution::par_unseq, output.begin(), output.end(), output.begin(), scale);
+			pixel::Pipeline<>{}.run(output, output, std::thread::hardware_concurrency(), &histogram);
+			bench::do_not_optimize(output.data());
+		}, options));
+		results.push_back(bench::run(traffic[1].first, [&] {
+			fused.run(image, output, std::thread::hardware_concurrency(), &histogram);
+			bench::do_not_optimize(output.data());
+		}, options));
+
+		for (size_t i = 0; i < 2; ++i)
+		{
+			const bench::Result& r = results[results.size() - 2 + i];
+			std::cout << r.name << ": " << traffic[i].second / r.median / 1e9 << " GB/s memory traffic, "
+					  << image_bytes / r.median / 1e9 << " GB/s of image processed\n";
+		}
+	}
+
+	for (const auto& r : results)
+		std::cout << r << "\n";
+
+	if (!json_file.empty())
+	{
+		std::ofstream out{json_file};
+		bench::write_json(out, results);
+	}
 }
 
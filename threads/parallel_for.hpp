@@ -0,0 +1,22 @@
+#ifndef PARALLEL_FOR_HPP
+#define PARALLEL_FOR_HPP
+
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// runs f(t) for t in [0, no_of_threads) on a thread each - t == 0 on the calling thread; returns when all are done
+template <typename F>
+void parallel_for_threads(size_t no_of_threads, F f)
+{
+	std::vector<std::thread> thds;
+	for (size_t t = 1; t < no_of_threads; ++t)
+		thds.emplace_back(f, t);
+
+	f(size_t{0});
+
+	for (auto& thd : thds)
+		thd.join();
+}
+
+#endif
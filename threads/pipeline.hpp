@@ -0,0 +1,580 @@
+#ifndef PIPELINE_HPP
+#define PIPELINE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <concepts>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+// Concurrent stages connected by bounded lock-free queues:
+//
+//   pipeline::Builder builder{16};
+//   builder.source("generate", 1, [](size_t i) -> std::optional<Chunk> { ... nullopt after the last chunk ... })
+//       .then("transform", 2, [](Chunk c) { ...; return c; })
+//       .sink("sort", 2, [](Chunk c) { ... });
+//   pipeline::Stats stats = builder.run();
+//
+// Every stage runs on `parallelism` threads. A full queue blocks its producers (backpressure), so at most
+// queue_capacity items are in flight between two stages and the working set stays small. Edges with one thread
+// on each side use an SPSC ring, all others an MPMC queue.
+namespace pipeline
+{
+	// spins with yield first, then sleeps - waiting threads leave the core to the ones doing work
+	class Backoff
+	{
+		unsigned attempts_ = 0;
+
+	public:
+		void pause()
+		{
+			if (attempts_++ < 64)
+				std::this_thread::yield();
+			else
+				std::this_thread::sleep_for(std::chrono::microseconds{50});
+		}
+	};
+
+	// bounded single-producer/single-consumer ring; capacity is rounded up to a power of two
+	template <std::default_initializable T>
+	class SpscQueue
+	{
+		std::vector<T> slots_;
+		const size_t mask_;
+
+		alignas(64) std::atomic<size_t> head_ = 0; // next slot to pop - written by the consumer
+		alignas(64) std::atomic<size_t> tail_ = 0; // next slot to push - written by the producer
+
+	public:
+		explicit SpscQueue(size_t capacity) : slots_(std::bit_ceil(std::max<size_t>(capacity, 1))), mask_{slots_.size() - 1} {}
+
+		// item is moved from only on success
+		bool try_push(T& item)
+		{
+			const size_t tail = tail_.load(std::memory_order_relaxed);
+			if (tail - head_.load(std::memory_order_acquire) == slots_.size())
+				return false;
+
+			slots_[tail & mask_] = std::move(item);
+			tail_.store(tail + 1, std::memory_order_release);
+			return true;
+		}
+
+		bool try_pop(T& item)
+		{
+			const size_t head = head_.load(std::memory_order_relaxed);
+			if (head == tail_.load(std::memory_order_acquire))
+				return false;
+
+			item = std::move(slots_[head & mask_]);
+			head_.store(head + 1, std::memory_order_release);
+			return true;
+		}
+
+		size_t size() const
+		{
+			return tail_.load(std::memory_order_relaxed) - head_.load(std::memory_order_relaxed);
+		}
+
+		size_t capacity() const { return slots_.size(); }
+	};
+
+	// bounded multi-producer/multi-consumer queue (D. Vyukov): every cell carries a sequence number telling
+	// whether it is ready for the producer or the consumer at a given position, so a push or pop is one CAS
+	template <std::default_initializable T>
+	class MpmcQueue
+	{
+		struct Cell
+		{
+			std::atomic<size_t> sequence;
+			T value;
+		};
+
+		std::vector<Cell> cells_;
+		const size_t mask_;
+
+		alignas(64) std::atomic<size_t> enqueue_pos_ = 0;
+		alignas(64) std::atomic<size_t> dequeue_pos_ = 0;
+
+	public:
+		explicit MpmcQueue(size_t capacity) : cells_(std::bit_ceil(std::max<size_t>(capacity, 1))), mask_{cells_.size() - 1}
+		{
+			for (size_t i = 0; i < cells_.size(); ++i)
+				cells_[i].sequence.store(i, std::memory_order_relaxed);
+		}
+
+		// item is moved from only on success
+		bool try_push(T& item)
+		{
+			size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+			while (true)
+			{
+				Cell& cell = cells_[pos & mask_];
+				const auto diff = static_cast<intptr_t>(cell.sequence.load(std::memory_order_acquire)) - static_cast<intptr_t>(pos);
+
+				if (diff == 0)
+				{
+					if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					{
+						cell.value = std::move(item);
+						cell.sequence.store(pos + 1, std::memory_order_release);
+						return true;
+					}
+				}
+				else if (diff < 0)
+					return false; // full - the cell still holds an item from one lap ago
+				else
+					pos = enqueue_pos_.load(std::memory_order_relaxed);
+			}
+		}
+
+		bool try_pop(T& item)
+		{
+			size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+			while (true)
+			{
+				Cell& cell = cells_[pos & mask_];
+				const auto diff = static_cast<intptr_t>(cell.sequence.load(std::memory_order_acquire)) - static_cast<intptr_t>(pos + 1);
+
+				if (diff == 0)
+				{
+					if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					{
+						item = std::move(cell.value);
+						cell.sequence.store(pos + mask_ + 1, std::memory_order_release);
+						return true;
+					}
+				}
+				else if (diff < 0)
+					return false; // empty
+				else
+					pos = dequeue_pos_.load(std::memory_order_relaxed);
+			}
+		}
+
+		size_t size() const
+		{
+			const size_t enqueued = enqueue_pos_.load(std::memory_order_relaxed);
+			const size_t dequeued = dequeue_pos_.load(std::memory_order_relaxed);
+			return (enqueued > dequeued) ? enqueued - dequeued : 0;
+		}
+
+		size_t capacity() const { return cells_.size(); }
+	};
+
+	struct StageStats
+	{
+		std::string name;
+		size_t parallelism = 0;
+		uint64_t items = 0;
+		double busy_seconds = 0;        // in the stage function, summed over threads
+		double input_wait_seconds = 0;  // waiting for an item from the previous stage
+		double output_wait_seconds = 0; // blocked on a full queue to the next stage - backpressure
+		size_t input_capacity = 0;      // 0 for the source
+		double mean_input_occupancy = 0; // items queued for this stage, seen when it takes one
+		size_t max_input_occupancy = 0;
+	};
+
+	struct Stats
+	{
+		double seconds = 0;
+		std::vector<StageStats> stages;
+	};
+
+	inline std::ostream& operator<<(std::ostream& out, const Stats& stats)
+	{
+		const auto flags = out.flags();
+		const auto precision = out.precision();
+
+		out << std::fixed << std::setprecision(2) << "pipeline: " << stats.seconds * 1e3 << "ms\n";
+		for (const auto& s : stats.stages)
+		{
+			out << "  " << s.name << " x" << s.parallelism << ": " << s.items << " items, "
+				<< s.items / stats.seconds << " items/s, busy " << s.busy_seconds * 1e3 << "ms, waits in/out "
+				<< s.input_wait_seconds * 1e3 << "/" << s.output_wait_seconds * 1e3 << "ms";
+			if (s.input_capacity > 0)
+				out << ", input queue " << s.mean_input_occupancy << " avg / " << s.max_input_occupancy << " max of " << s.input_capacity;
+			out << "\n";
+		}
+
+		out.flags(flags);
+		out.precision(precision);
+		return out;
+	}
+
+	namespace detail
+	{
+		inline double seconds_since(std::chrono::steady_clock::time_point start)
+		{
+			return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		// shared between the stages of one run - an exception in any stage stops all of them
+		struct RunState
+		{
+			std::atomic<bool> cancelled = false;
+			std::mutex mtx;
+			std::exception_ptr error;
+
+			void fail(std::exception_ptr e)
+			{
+				std::lock_guard lk{mtx};
+				if (!error)
+					error = e;
+				cancelled = true;
+			}
+		};
+
+		// queue of one edge; closed when the last producer thread is done
+		template <typename T>
+		class Channel
+		{
+			std::variant<SpscQueue<T>, MpmcQueue<T>> queue_;
+			std::atomic<size_t> producers_left_;
+			RunState& state_;
+
+		public:
+			Channel(size_t capacity, size_t producers, size_t consumers, RunState& state)
+				: queue_{make_queue(capacity, producers, consumers)}, producers_left_{producers}, state_{state}
+			{
+			}
+
+			// false if the run was cancelled
+			bool push(T& item, double& wait_seconds)
+			{
+				if (try_push(item))
+					return true;
+
+				const auto start = std::chrono::steady_clock::now();
+				Backoff backoff;
+				while (!try_push(item))
+				{
+					if (state_.cancelled)
+						return false;
+					backoff.pause();
+				}
+				wait_seconds += seconds_since(start);
+				return true;
+			}
+
+			// false once all producers are done and the queue is drained (or the run was cancelled)
+			bool pop(T& item, double& wait_seconds)
+			{
+				if (try_pop(item))
+					return true;
+
+				const auto start = std::chrono::steady_clock::now();
+				Backoff backoff;
+				while (!try_pop(item))
+				{
+					if (producers_left_.load(std::memory_order_acquire) == 0)
+					{
+						// every push happened before the last producer_done()
+						const bool popped = try_pop(item);
+						wait_seconds += seconds_since(start);
+						return popped;
+					}
+					if (state_.cancelled)
+						return false;
+					backoff.pause();
+				}
+				wait_seconds += seconds_since(start);
+				return true;
+			}
+
+			void producer_done() { producers_left_.fetch_sub(1, std::memory_order_release); }
+
+			size_t size() const
+			{
+				return std::visit([](const auto& queue) { return queue.size(); }, queue_);
+			}
+
+			size_t capacity() const
+			{
+				return std::visit([](const auto& queue) { return queue.capacity(); }, queue_);
+			}
+
+		private:
+			static std::variant<SpscQueue<T>, MpmcQueue<T>> make_queue(size_t capacity, size_t producers, size_t consumers)
+			{
+				if (producers == 1 && consumers == 1)
+					return std::variant<SpscQueue<T>, MpmcQueue<T>>{std::in_place_type<SpscQueue<T>>, capacity};
+				return std::variant<SpscQueue<T>, MpmcQueue<T>>{std::in_place_type<MpmcQueue<T>>, capacity};
+			}
+
+			bool try_push(T& item)
+			{
+				return std::visit([&item](auto& queue) { return queue.try_push(item); }, queue_);
+			}
+
+			bool try_pop(T& item)
+			{
+				return std::visit([&item](auto& queue) { return queue.try_pop(item); }, queue_);
+			}
+		};
+
+		// per-thread counters added to the stage stats when the thread is done
+		struct WorkerStats
+		{
+			uint64_t items = 0;
+			double busy_seconds = 0;
+			double input_wait_seconds = 0;
+			double output_wait_seconds = 0;
+			uint64_t occupancy_sum = 0;
+			size_t max_occupancy = 0;
+		};
+
+		struct Stage
+		{
+			StageStats stats;
+			std::mutex mtx;
+
+			void add(const WorkerStats& w)
+			{
+				std::lock_guard lk{mtx};
+				stats.items += w.items;
+				stats.busy_seconds += w.busy_seconds;
+				stats.input_wait_seconds += w.input_wait_seconds;
+				stats.output_wait_seconds += w.output_wait_seconds;
+				stats.max_input_occupancy = std::max(stats.max_input_occupancy, w.max_occupancy);
+				stats.mean_input_occupancy += static_cast<double>(w.occupancy_sum); // divided by items in run()
+			}
+		};
+	}
+
+	template <typename T>
+	class Flow;
+
+	class Builder
+	{
+		template <typename T>
+		friend class Flow;
+
+		size_t queue_capacity_;
+		std::shared_ptr<detail::RunState> state_ = std::make_shared<detail::RunState>();
+		std::vector<std::unique_ptr<detail::Stage>> stages_;
+		std::vector<std::function<void()>> workers_; // one per thread
+		bool complete_ = false;
+		bool ran_ = false;
+
+		detail::Stage& add_stage(std::string name, size_t parallelism, size_t input_capacity)
+		{
+			auto stage = std::make_unique<detail::Stage>();
+			stage->stats.name = std::move(name);
+			stage->stats.parallelism = parallelism;
+			stage->stats.input_capacity = input_capacity;
+			stages_.push_back(std::move(stage));
+			return *stages_.back();
+		}
+
+	public:
+		explicit Builder(size_t queue_capacity = 16) : queue_capacity_{std::max<size_t>(queue_capacity, 1)} {}
+
+		Builder(const Builder&) = delete;
+		Builder& operator=(const Builder&) = delete;
+
+		// generate(i) for i = 0, 1, 2, ... (indices shared by all threads of the stage) until it returns nullopt;
+		// after the first nullopt it must return nullopt for all larger indices
+		template <typename F>
+		auto source(std::string name, size_t parallelism, F generate)
+		{
+			using T = typename std::invoke_result_t<F&, size_t>::value_type;
+			return Flow<T>{*this, std::move(name), std::max<size_t>(parallelism, 1), std::move(generate)};
+		}
+
+		// runs all stages to completion; rethrows the first exception thrown by a stage function.
+		// Single-shot: the stage threads are consumed, a second call throws std::logic_error.
+		Stats run()
+		{
+			if (!complete_)
+				throw std::logic_error("pipeline has no sink");
+			if (ran_)
+				throw std::logic_error("pipeline has already run");
+			ran_ = true;
+
+			const auto start = std::chrono::steady_clock::now();
+
+			std::vector<std::thread> thds;
+			for (auto& worker : workers_)
+				thds.emplace_back(std::move(worker));
+			for (auto& thd : thds)
+				thd.join();
+			workers_.clear();
+
+			Stats stats{detail::seconds_since(start), {}};
+			for (const auto& stage : stages_)
+			{
+				stats.stages.push_back(stage->stats);
+				auto& s = stats.stages.back();
+				s.mean_input_occupancy = (s.items > 0) ? s.mean_input_occupancy / static_cast<double>(s.items) : 0.0;
+			}
+
+			if (state_->error)
+				std::rethrow_exception(state_->error);
+
+			return stats;
+		}
+	};
+
+	// output of a stage - the next stage is attached with then() or sink()
+	template <typename T>
+	class Flow
+	{
+		friend class Builder;
+
+		template <typename U>
+		friend class Flow;
+
+		Builder& builder_;
+		std::string name_;
+		size_t parallelism_;
+		std::function<void(std::shared_ptr<detail::Channel<T>>)> attach_; // creates the producer threads once the consumer is known
+
+		template <typename F>
+		Flow(Builder& builder, std::string name, size_t parallelism, F generate)
+			: builder_{builder}, name_{std::move(name)}, parallelism_{parallelism}
+		{
+			attach_ = [&builder, name = name_, parallelism, generate = std::move(generate)](std::shared_ptr<detail::Channel<T>> output) mutable {
+				detail::Stage& stage = builder.add_stage(name, parallelism, 0);
+				auto next_index = std::make_shared<std::atomic<size_t>>(0);
+				auto state = builder.state_;
+
+				for (size_t t = 0; t < parallelism; ++t)
+					builder.workers_.push_back([&stage, output, next_index, state, generate]() mutable {
+						detail::WorkerStats w;
+						try
+						{
+							while (!state->cancelled)
+							{
+								const auto start = std::chrono::steady_clock::now();
+								std::optional<T> item = generate((*next_index)++);
+								w.busy_seconds += detail::seconds_since(start);
+								if (!item)
+									break;
+
+								++w.items;
+								if (!output->push(*item, w.output_wait_seconds))
+									break;
+							}
+						}
+						catch (...)
+						{
+							state->fail(std::current_exception());
+						}
+						output->producer_done();
+						stage.add(w);
+					});
+			};
+		}
+
+		template <typename Input, typename F>
+		Flow(Builder& builder, std::string name, size_t parallelism, std::shared_ptr<detail::Channel<Input>> input, F f)
+			: builder_{builder}, name_{std::move(name)}, parallelism_{parallelism}
+		{
+			attach_ = [&builder, name = name_, parallelism, input, f = std::move(f)](std::shared_ptr<detail::Channel<T>> output) mutable {
+				detail::Stage& stage = builder.add_stage(name, parallelism, input->capacity());
+				auto state = builder.state_;
+
+				for (size_t t = 0; t < parallelism; ++t)
+					builder.workers_.push_back([&stage, input, output, state, f]() mutable {
+						detail::WorkerStats w;
+						try
+						{
+							for (Input item; input->pop(item, w.input_wait_seconds);)
+							{
+								const size_t occupancy = input->size() + 1; // with the item just taken
+								w.occupancy_sum += occupancy;
+								w.max_occupancy = std::max(w.max_occupancy, occupancy);
+
+								const auto start = std::chrono::steady_clock::now();
+								T result = f(std::move(item));
+								w.busy_seconds += detail::seconds_since(start);
+
+								++w.items;
+								if (!output->push(result, w.output_wait_seconds))
+									break;
+							}
+						}
+						catch (...)
+						{
+							state->fail(std::current_exception());
+						}
+						output->producer_done();
+						stage.add(w);
+					});
+			};
+		}
+
+		// queue from this stage to a consumer stage with the given parallelism; creates this stage's threads
+		std::shared_ptr<detail::Channel<T>> connect(size_t consumers)
+		{
+			auto channel = std::make_shared<detail::Channel<T>>(builder_.queue_capacity_, parallelism_, consumers, *builder_.state_);
+			attach_(channel);
+			attach_ = nullptr;
+			return channel;
+		}
+
+	public:
+		// stage consuming items of this one: f(T) -> U
+		template <typename F>
+		auto then(std::string name, size_t parallelism, F f)
+		{
+			using U = std::invoke_result_t<F&, T>;
+			parallelism = std::max<size_t>(parallelism, 1);
+			return Flow<U>{builder_, std::move(name), parallelism, connect(parallelism), std::move(f)};
+		}
+
+		// last stage: f(T)
+		template <typename F>
+		void sink(std::string name, size_t parallelism, F f)
+		{
+			parallelism = std::max<size_t>(parallelism, 1);
+			auto input = connect(parallelism);
+			detail::Stage& stage = builder_.add_stage(std::move(name), parallelism, input->capacity());
+			auto state = builder_.state_;
+
+			for (size_t t = 0; t < parallelism; ++t)
+				builder_.workers_.push_back([&stage, input, state, f]() mutable {
+					detail::WorkerStats w;
+					try
+					{
+						for (T item; input->pop(item, w.input_wait_seconds);)
+						{
+							const size_t occupancy = input->size() + 1; // with the item just taken
+							w.occupancy_sum += occupancy;
+							w.max_occupancy = std::max(w.max_occupancy, occupancy);
+
+							const auto start = std::chrono::steady_clock::now();
+							f(std::move(item));
+							w.busy_seconds += detail::seconds_since(start);
+							++w.items;
+						}
+					}
+					catch (...)
+					{
+						state->fail(std::current_exception());
+					}
+					stage.add(w);
+				});
+
+			builder_.complete_ = true;
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,159 @@
+#ifndef PIXEL_PIPELINE_HPP
+#define PIXEL_PIPELINE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+// Point operations on pixel buffers fused into a single pass:
+//
+//   pixel::Histogram histogram{0, 1'000'000, 256};
+//   pixel::Pipeline pipeline{pixel::Threshold{10'000}, pixel::Clamp{0, 900'000}, pixel::Scale{0.5f}};
+//   pipeline.run(image, image, threads, &histogram);
+//
+// Threads take tiles of tile_size pixels from a shared counter. Every tile goes through all stages
+// in one branch-free loop the compiler vectorizes, and then through the histogram while it is still in cache,
+// so the buffer crosses the memory bus once - not once per stage as with chained std::transform calls.
+namespace pixel
+{
+	using Pixel = int32_t;
+
+	// pixels darker than level become black
+	struct Threshold
+	{
+		Pixel level;
+
+		Pixel operator()(Pixel p) const { return (p < level) ? 0 : p; }
+	};
+
+	struct Clamp
+	{
+		Pixel lo;
+		Pixel hi;
+
+		Pixel operator()(Pixel p) const { return std::min(std::max(p, lo), hi); }
+	};
+
+	// exact for pixels below 2^24
+	struct Scale
+	{
+		float factor;
+
+		Pixel operator()(Pixel p) const { return static_cast<Pixel>(static_cast<float>(p) * factor); }
+	};
+
+	// no_of_bins bins of equal width over [lo, hi]; pixels outside the range count to the first or last bin
+	class Histogram
+	{
+		Pixel lo_;
+		double bins_per_value_;
+		std::vector<uint64_t> counts_;
+
+	public:
+		Histogram(Pixel lo, Pixel hi, size_t no_of_bins)
+			: lo_{lo}, bins_per_value_{static_cast<double>(no_of_bins) / (static_cast<double>(hi) - lo + 1)}, counts_(no_of_bins)
+		{
+			if (hi < lo || no_of_bins == 0)
+				throw std::invalid_argument("empty histogram range");
+		}
+
+		size_t bin(Pixel p) const
+		{
+			const double b = (static_cast<double>(p) - lo_) * bins_per_value_;
+			return static_cast<size_t>(std::clamp(b, 0.0, static_cast<double>(counts_.size() - 1)));
+		}
+
+		void add(Pixel p) { ++counts_[bin(p)]; }
+
+		// adds counts of a histogram with the same range and bins
+		void merge(const Histogram& other)
+		{
+			for (size_t b = 0; b < counts_.size(); ++b)
+				counts_[b] += other.counts_[b];
+		}
+
+		void clear() { std::fill(counts_.begin(), counts_.end(), 0); }
+
+		const std::vector<uint64_t>& counts() const { return counts_; }
+	};
+
+	template <typename... Stages>
+	class Pipeline
+	{
+		std::tuple<Stages...> stages_;
+
+	public:
+		static constexpr size_t default_tile_size = 16 * 1024; // 64 KB in and out - fits into L2
+
+		explicit Pipeline(Stages... stages) : stages_{stages...} {}
+
+		// all stages applied to one pixel
+		Pixel operator()(Pixel p) const
+		{
+			std::apply([&p](const auto&... stage) { ((p = stage(p)), ...); }, stages_);
+			return p;
+		}
+
+		// out[i] = (*this)(in[i]) and, with a histogram, counts of the output pixels added to it;
+		// in and out may be the same buffer - a pipeline without stages then only reads it (a histogram pass)
+		void run(std::span<const Pixel> in, std::span<Pixel> out,
+			size_t no_of_threads = std::max(1u, std::thread::hardware_concurrency()),
+			Histogram* histogram = nullptr, size_t tile_size = default_tile_size) const
+		{
+			if (out.size() < in.size())
+				throw std::invalid_argument("output smaller than input");
+
+			tile_size = std::max<size_t>(tile_size, 1);
+			const size_t no_of_tiles = (in.size() + tile_size - 1) / tile_size;
+			no_of_threads = std::clamp<size_t>(no_of_threads, 1, std::max<size_t>(no_of_tiles, 1));
+
+			std::atomic<size_t> next_tile = 0;
+			std::vector<Histogram> local_histograms(histogram ? no_of_threads : 0, histogram ? *histogram : Histogram{0, 0, 1});
+			for (auto& local : local_histograms)
+				local.clear();
+
+			auto worker = [&](size_t t) {
+				for (size_t tile; (tile = next_tile++) < no_of_tiles;)
+				{
+					const size_t first = tile * tile_size;
+					const size_t last = std::min(first + tile_size, in.size());
+					const Pixel* src = in.data();
+					Pixel* dst = out.data();
+
+					if (sizeof...(Stages) > 0 || src != dst)
+						for (size_t i = first; i < last; ++i)
+							dst[i] = (*this)(src[i]);
+
+					if (histogram)
+						for (size_t i = first; i < last; ++i)
+							local_histograms[t].add(dst[i]);
+				}
+			};
+
+			std::vector<std::thread> thds;
+			for (size_t t = 1; t < no_of_threads; ++t)
+				thds.emplace_back(worker, t);
+
+			worker(0);
+
+			for (auto& thd : thds)
+				thd.join();
+
+			for (const auto& local : local_histograms)
+				histogram->merge(local);
+		}
+
+		void run(std::span<Pixel> pixels, size_t no_of_threads = std::max(1u, std::thread::hardware_concurrency()),
+			Histogram* histogram = nullptr) const
+		{
+			run(pixels, pixels, no_of_threads, histogram);
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,113 @@
+#ifndef RADIX_SORT_HPP
+#define RADIX_SORT_HPP
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "parallel_for.hpp"
+
+namespace radix_detail
+{
+	// order-preserving map to an unsigned key: signed values get their sign bit flipped
+	template <std::integral Key>
+	auto to_unsigned(Key key)
+	{
+		using U = std::make_unsigned_t<Key>;
+		if constexpr (std::is_signed_v<Key>)
+			return static_cast<U>(static_cast<U>(key) ^ (U{1} << (sizeof(U) * 8 - 1)));
+		else
+			return static_cast<U>(key);
+	}
+}
+
+// Stable parallel LSD radix sort on 8-bit digits for 8- to 64-bit integer keys.
+// key_of projects an element to its key, so records with payloads are sorted by one of their fields:
+//   radix_sort(records, threads, [](const Record& r) { return r.id; });
+// Every pass counts digits in per-thread histograms over contiguous chunks, turns them into per-thread
+// output offsets and scatters each chunk in order (which keeps the sort stable). Passes where all
+// elements share the same digit are skipped, so keys from a small range (e.g. [0, 10^6]) cost 3 passes, not 4.
+// Needs a temporary buffer of data.size() elements.
+template <typename T, typename KeyOf = std::identity>
+	requires std::integral<std::remove_cvref_t<std::invoke_result_t<KeyOf, const T&>>>
+void radix_sort(std::vector<T>& data, size_t no_of_threads = std::max(1u, std::thread::hardware_concurrency()), KeyOf key_of = {})
+{
+	using Key = std::remove_cvref_t<std::invoke_result_t<KeyOf, const T&>>;
+	constexpr size_t no_of_passes = sizeof(Key);
+	constexpr size_t radix = 256;
+	constexpr size_t min_chunk = 1 << 16; // smaller chunks do not pay for a thread
+
+	const size_t n = data.size();
+	if (n < 2)
+		return;
+
+	no_of_threads = std::clamp<size_t>(n / min_chunk, 1, std::max<size_t>(no_of_threads, 1));
+
+	auto digit = [&key_of](const T& item, size_t pass) {
+		return static_cast<size_t>((radix_detail::to_unsigned(std::invoke(key_of, item)) >> (8 * pass)) & 0xFF);
+	};
+
+	auto chunk_begin = [=](size_t t) { return n * t / no_of_threads; };
+
+	std::vector<T> buffer(n);
+	std::vector<T>* from = &data;
+	std::vector<T>* to = &buffer;
+
+	std::vector<std::array<size_t, radix>> histograms(no_of_threads);
+
+	for (size_t pass = 0; pass < no_of_passes; ++pass)
+	{
+		parallel_for_threads(no_of_threads, [&](size_t t) {
+			std::array<size_t, radix> histogram{}; // local copy - no false sharing, no aliasing with src
+
+			const T* src = from->data();
+			for (size_t i = chunk_begin(t), last = chunk_begin(t + 1); i < last; ++i)
+				++histogram[digit(src[i], pass)];
+
+			histograms[t] = histogram;
+		});
+
+		// all elements in one bucket - this digit does not change the order
+		bool trivial = false;
+		for (size_t d = 0; d < radix && !trivial; ++d)
+		{
+			size_t total = 0;
+			for (const auto& histogram : histograms)
+				total += histogram[d];
+			trivial = (total == n);
+		}
+		if (trivial)
+			continue;
+
+		// histograms become output offsets: all smaller digits first, then the same digit of earlier chunks
+		size_t offset = 0;
+		for (size_t d = 0; d < radix; ++d)
+			for (auto& histogram : histograms)
+			{
+				const size_t count = histogram[d];
+				histogram[d] = offset;
+				offset += count;
+			}
+
+		parallel_for_threads(no_of_threads, [&](size_t t) {
+			std::array<size_t, radix> offsets = histograms[t];
+			T* src = from->data();
+			T* dst = to->data();
+
+			for (size_t i = chunk_begin(t), last = chunk_begin(t + 1); i < last; ++i)
+				dst[offsets[digit(src[i], pass)]++] = std::move(src[i]);
+		});
+
+		std::swap(from, to);
+	}
+
+	if (from != &data)
+		data = std::move(*from);
+}
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef RANDOM_FILL_HPP
+#define RANDOM_FILL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "splitmix64.hpp"
+
+// Uniform integers in [a, b] for ranges of up to 2^32 values with Lemire's nearly divisionless method:
+// the upper 32 bits of x * range (x - 32 random bits) are the result, a modulo is computed only when
+// the lower 32 bits fall below range - with probability range / 2^32 - and only to reject the few biased values.
+template <std::integral T>
+class BoundedIntDistribution
+{
+	T a_;
+	uint64_t range_;
+
+public:
+	BoundedIntDistribution(T a, T b) : a_{a}, range_{static_cast<uint64_t>(b) - static_cast<uint64_t>(a) + 1}
+	{
+		if (b < a || range_ - 1 > std::numeric_limits<uint32_t>::max())
+			throw std::invalid_argument("range must have 1 to 2^32 values");
+	}
+
+	T a() const { return a_; }
+	T b() const { return static_cast<T>(static_cast<uint64_t>(a_) + range_ - 1); }
+
+	template <typename RndGen>
+		requires(RndGen::max() == std::numeric_limits<uint64_t>::max() && RndGen::min() == 0)
+	T operator()(RndGen& rnd_gen) const
+	{
+		uint64_t x = rnd_gen() >> 32;
+		if (range_ > std::numeric_limits<uint32_t>::max()) // all 2^32 values
+			return static_cast<T>(static_cast<uint64_t>(a_) + x);
+
+		uint64_t m = x * range_;
+		auto low = static_cast<uint32_t>(m);
+		if (low < range_)
+		{
+			const auto range = static_cast<uint32_t>(range_);
+			const uint32_t threshold = (0u - range) % range; // 2^32 mod range
+			while (low < threshold)
+			{
+				x = rnd_gen() >> 32;
+				m = x * range_;
+				low = static_cast<uint32_t>(m);
+			}
+		}
+
+		return static_cast<T>(static_cast<uint64_t>(a_) + (m >> 32));
+	}
+};
+
+// data[i] = generate(rnd_gen), where rnd_gen is the SplitMix64 stream of the chunk containing i.
+// Chunks have a fixed size and threads take them from a shared counter, so the result depends on the seed only,
+// not on the number of threads. generate is copied for every chunk and may keep state (e.g. a distribution).
+template <typename T, typename Generate>
+void parallel_fill(std::vector<T>& data, uint64_t seed, Generate generate,
+	size_t no_of_threads = std::max(1u, std::thread::hardware_concurrency()))
+{
+	constexpr size_t chunk_size = 1 << 16;
+
+	const size_t no_of_chunks = (data.size() + chunk_size - 1) / chunk_size;
+	no_of_threads = std::clamp<size_t>(no_of_threads, 1, std::max<size_t>(no_of_chunks, 1));
+
+	std::atomic<size_t> next_chunk = 0;
+
+	auto worker = [&] {
+		for (size_t chunk; (chunk = next_chunk++) < no_of_chunks;)
+		{
+			SplitMix64 rnd_gen = SplitMix64::stream(seed, chunk);
+			Generate chunk_generate = generate;
+
+			T* dst = data.data();
+			for (size_t i = chunk * chunk_size, last = std::min(i + chunk_size, data.size()); i < last; ++i)
+				dst[i] = chunk_generate(rnd_gen);
+		}
+	};
+
+	std::vector<std::thread> thds;
+	for (size_t t = 1; t < no_of_threads; ++t)
+		thds.emplace_back(worker);
+
+	worker();
+
+	for (auto& thd : thds)
+		thd.join();
+}
+
+// uniform integers in [a, b]
+template <std::integral T>
+void parallel_fill_uniform(std::vector<T>& data, T a, T b, uint64_t seed,
+	size_t no_of_threads = std::max(1u, std::thread::hardware_concurrency()))
+{
+	parallel_fill(data, seed, [distr = BoundedIntDistribution<T>{a, b}](SplitMix64& rnd_gen) { return distr(rnd_gen); }, no_of_threads);
+}
+
+#endif
@@ -0,0 +1,206 @@
+#ifndef SELECTION_HPP
+#define SELECTION_HPP
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+#include "parallel_for.hpp"
+
+// Parallel selection - for jobs that need the best k elements or one order statistic, not a full sort.
+// All take a strict weak ordering comp (as the std:: algorithms do) and split the data into one contiguous chunk
+// per thread; ranges below min_parallel_size are handed to the std:: algorithm directly.
+namespace selection_detail
+{
+	constexpr size_t min_parallel_size = 1 << 16;
+
+	inline size_t effective_threads(size_t n, size_t no_of_threads)
+	{
+		return std::clamp<size_t>(n / min_parallel_size, 1, std::max<size_t>(no_of_threads, 1));
+	}
+
+	// sorts [first, last): sorted chunks merged pairwise in rounds, the merges of one round in parallel
+	template <typename Iterator, typename Compare>
+	void parallel_sort(Iterator first, Iterator last, size_t no_of_threads, Compare comp)
+	{
+		const size_t n = static_cast<size_t>(last - first);
+		no_of_threads = effective_threads(n, no_of_threads);
+
+		std::vector<size_t> bounds(no_of_threads + 1);
+		for (size_t t = 0; t <= no_of_threads; ++t)
+			bounds[t] = n * t / no_of_threads;
+
+		parallel_for_threads(no_of_threads, [&](size_t t) {
+			std::sort(first + bounds[t], first + bounds[t + 1], comp);
+		});
+
+		for (size_t width = 1; width < no_of_threads; width *= 2)
+		{
+			const size_t no_of_merges = (no_of_threads + 2 * width - 1) / (2 * width);
+			parallel_for_threads(no_of_merges, [&](size_t m) {
+				const size_t left = 2 * width * m;
+				const size_t middle = std::min(left + width, no_of_threads);
+				const size_t right = std::min(left + 2 * width, no_of_threads);
+				if (middle < right)
+					std::inplace_merge(first + bounds[left], first + bounds[middle], first + bounds[right], comp);
+			});
+		}
+	}
+}
+
+// The k elements that come first in the order of comp (default: the k largest), in that order - like
+// std::partial_sort_copy. Every thread keeps the best k of its chunk in a heap whose top is the worst of them,
+// so most elements cost one comparison; the per-thread candidates are merged at the end.
+template <typename T, typename Compare = std::greater<>>
+std::vector<T> parallel_top_k(const std::vector<T>& data, size_t k,
+	size_t no_of_threads = std::max(1u, std::thread::hardware_concurrency()), Compare comp = {})
+{
+	k = std::min(k, data.size());
+	if (k == 0)
+		return {};
+
+	no_of_threads = selection_detail::effective_threads(data.size(), no_of_threads);
+	std::vector<std::vector<T>> heaps(no_of_threads);
+
+	parallel_for_threads(no_of_threads, [&](size_t t) {
+		const size_t first = data.size() * t / no_of_threads;
+		const size_t last = data.size() * (t + 1) / no_of_threads;
+
+		std::vector<T> heap;
+		heap.reserve(k);
+		for (size_t i = first; i < last; ++i)
+		{
+			if (heap.size() < k)
+			{
+				heap.push_back(data[i]);
+				std::push_heap(heap.begin(), heap.end(), comp);
+			}
+			else if (comp(data[i], heap.front()))
+			{
+				std::pop_heap(heap.begin(), heap.end(), comp);
+				heap.back() = data[i];
+				std::push_heap(heap.begin(), heap.end(), comp);
+			}
+		}
+
+		heaps[t] = std::move(heap);
+	});
+
+	std::vector<T> candidates = std::move(heaps[0]);
+	for (size_t t = 1; t < no_of_threads; ++t)
+		candidates.insert(candidates.end(), heaps[t].begin(), heaps[t].end());
+
+	std::partial_sort(candidates.begin(), candidates.begin() + k, candidates.end(), comp);
+	candidates.resize(k);
+	return candidates;
+}
+
+// Rearranges data like std::nth_element: data[n] is the element that would be there if data were sorted,
+// no element before it is greater, no element after it is smaller.
+// Parallel introselect: the pivot is the median of a sample; every thread counts how many elements of its chunk
+// are less than, equal to or greater than the pivot, the counts give each thread its output offsets
+// and the chunks are partitioned in parallel into a buffer. The search continues in the part containing n -
+// done when that is the run of pivot-equal elements. If partitioning stops shrinking the range quickly
+// (repeatedly more than 3/4 of it left), the rest goes to std::nth_element.
+template <typename T, typename Compare = std::less<>>
+void parallel_nth_element(std::vector<T>& data, size_t n,
+	size_t no_of_threads = std::max(1u, std::thread::hardware_concurrency()), Compare comp = {})
+{
+	if (n >= data.size())
+		return;
+
+	constexpr size_t sample_size = 127;
+
+	std::vector<T> buffer;
+	size_t lo = 0;
+	size_t hi = data.size();
+	size_t bad_rounds = 0;
+
+	// one thread: std::nth_element does the same without the buffer
+	while (selection_detail::effective_threads(hi - lo, no_of_threads) > 1 && bad_rounds < 2)
+	{
+		const size_t size = hi - lo;
+		const size_t threads = selection_detail::effective_threads(size, no_of_threads);
+
+		// pivot: median of evenly spaced samples
+		std::vector<T> sample;
+		sample.reserve(sample_size);
+		for (size_t s = 0; s < sample_size; ++s)
+			sample.push_back(data[lo + size * s / sample_size + size / (2 * sample_size)]);
+		std::nth_element(sample.begin(), sample.begin() + sample_size / 2, sample.end(), comp);
+		const T pivot = sample[sample_size / 2];
+
+		auto chunk_begin = [&](size_t t) { return lo + size * t / threads; };
+
+		std::vector<std::array<size_t, 3>> counts(threads); // less, equal, greater
+		parallel_for_threads(threads, [&](size_t t) {
+			std::array<size_t, 3> local{};
+			for (size_t i = chunk_begin(t), last = chunk_begin(t + 1); i < last; ++i)
+				++local[comp(data[i], pivot) ? 0 : (comp(pivot, data[i]) ? 2 : 1)];
+			counts[t] = local;
+		});
+
+		// output offsets: all "less" chunks first, then all "equal", then all "greater"
+		size_t offset = 0;
+		for (size_t part = 0; part < 3; ++part)
+			for (auto& count : counts)
+			{
+				const size_t c = count[part];
+				count[part] = offset;
+				offset += c;
+			}
+		const size_t less_end = counts[0][1];
+		const size_t equal_end = counts[0][2];
+
+		if (buffer.size() < size)
+			buffer.resize(size);
+
+		parallel_for_threads(threads, [&](size_t t) {
+			std::array<size_t, 3> offsets = counts[t];
+			for (size_t i = chunk_begin(t), last = chunk_begin(t + 1); i < last; ++i)
+				buffer[offsets[comp(data[i], pivot) ? 0 : (comp(pivot, data[i]) ? 2 : 1)]++] = std::move(data[i]);
+		});
+
+		parallel_for_threads(threads, [&](size_t t) {
+			const size_t first = size * t / threads;
+			const size_t last = size * (t + 1) / threads;
+			std::move(buffer.begin() + first, buffer.begin() + last, data.begin() + lo + first);
+		});
+
+		const size_t target = n - lo;
+		if (target >= less_end && target < equal_end)
+			return; // n is inside the run of elements equal to the pivot
+
+		const size_t new_size = (target < less_end) ? less_end : size - equal_end;
+		bad_rounds = (new_size > size / 4 * 3) ? bad_rounds + 1 : 0;
+
+		if (target < less_end)
+			hi = lo + less_end;
+		else
+			lo = lo + equal_end;
+	}
+
+	std::nth_element(data.begin() + lo, data.begin() + n, data.begin() + hi, comp);
+}
+
+// Rearranges data like std::partial_sort: the first k positions hold the k smallest elements (by comp) in order,
+// the order of the rest is unspecified. A parallel nth_element splits off the k smallest, which are then sorted
+// in parallel.
+template <typename T, typename Compare = std::less<>>
+void parallel_partial_sort(std::vector<T>& data, size_t k,
+	size_t no_of_threads = std::max(1u, std::thread::hardware_concurrency()), Compare comp = {})
+{
+	k = std::min(k, data.size());
+	if (k == 0)
+		return;
+
+	if (k < data.size())
+		parallel_nth_element(data, k - 1, no_of_threads, comp);
+
+	selection_detail::parallel_sort(data.begin(), data.begin() + k, no_of_threads, comp);
+}
+
+#endif
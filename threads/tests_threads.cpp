@@ -0,0 +1,826 @@
+#include <algorithm>
+#include <atomic>
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "async_logger.hpp"
+#include "external_sort.hpp"
+#include "jobs.hpp"
+#include "pipeline.hpp"
+#include "pixel_pipeline.hpp"
+#include "radix_sort.hpp"
+#include "random_fill.hpp"
+#include "selection.hpp"
+#include "thread_pool.hpp"
+
+using namespace std::literals;
+
+TEST_CASE("ThreadPool")
+{
+	SECTION("submit returns results through futures")
+	{
+		ThreadPool pool{4};
+		REQUIRE(pool.size() == 4);
+
+		std::vector<std::future<int>> results;
+		for (int i = 0; i < 100; ++i)
+			results.push_back(pool.submit([](int x) { return x * x; }, i));
+
+		for (int i = 0; i < 100; ++i)
+			CHECK(results[i].get() == i * i);
+	}
+
+	SECTION("exceptions propagate to the caller")
+	{
+		ThreadPool pool{2};
+		auto result = pool.submit([]() -> std::string { throw std::out_of_range("task failed"); });
+
+		CHECK_THROWS_AS(result.get(), std::out_of_range);
+
+		// the worker survives
+		CHECK(pool.submit([] { return 42; }).get() == 42);
+	}
+
+	SECTION("move-only arguments")
+	{
+		ThreadPool pool{1};
+		auto result = pool.submit([](std::unique_ptr<int> p) { return *p; }, std::make_unique<int>(7));
+
+		CHECK(result.get() == 7);
+	}
+
+	SECTION("bounded queue applies backpressure")
+	{
+		ThreadPool pool{1, 2};
+
+		std::promise<void> release;
+		std::shared_future<void> released = release.get_future().share();
+		std::atomic<bool> started = false;
+
+		auto blocker = pool.submit([&] {
+			started = true;
+			released.wait();
+		});
+		while (!started)
+			std::this_thread::yield();
+
+		// the worker is busy - two tasks fit into the queue, the third one does not
+		auto a = pool.try_submit([] { return 1; });
+		auto b = pool.try_submit([] { return 2; });
+		auto c = pool.try_submit([] { return 3; });
+		CHECK(a.has_value());
+		CHECK(b.has_value());
+		CHECK(!c.has_value());
+
+		// a blocking submit waits until the worker takes a task
+		std::atomic<bool> submitted = false;
+		std::thread producer{[&] {
+			pool.submit([] {}).get();
+			submitted = true;
+		}};
+		std::this_thread::sleep_for(20ms);
+		CHECK(!submitted);
+
+		release.set_value();
+		producer.join();
+		CHECK(submitted);
+		CHECK(a->get() + b->get() == 3);
+		blocker.get();
+	}
+
+	SECTION("shutdown drains queued tasks")
+	{
+		std::atomic<int> done = 0;
+		{
+			ThreadPool pool{2};
+			for (int i = 0; i < 50; ++i)
+				pool.submit([&done] {
+					std::this_thread::sleep_for(100us);
+					++done;
+				});
+		} // destructor
+
+		CHECK(done == 50);
+	}
+
+	SECTION("submit after shutdown throws")
+	{
+		ThreadPool pool{1};
+		pool.shutdown();
+
+		CHECK_THROWS_AS(pool.submit([] {}), std::runtime_error);
+		CHECK_THROWS_AS(pool.try_submit([] {}), std::runtime_error);
+	}
+}
+
+TEST_CASE("radix_sort")
+{
+	std::mt19937_64 rnd_gen{665};
+
+	SECTION("bounded int keys - the threads/main.cpp workload")
+	{
+		std::uniform_int_distribution<> rnd_distr(0, 1'000'000);
+		std::vector<int> data(1'000'000);
+		std::generate(data.begin(), data.end(), [&] { return rnd_distr(rnd_gen); });
+
+		std::vector<int> expected = data;
+		std::sort(expected.begin(), expected.end());
+
+		for (size_t threads : {1, 3, 8})
+		{
+			std::vector<int> sorted = data;
+			radix_sort(sorted, threads);
+			CHECK(sorted == expected);
+		}
+	}
+
+	SECTION("signed and unsigned 64-bit keys")
+	{
+		std::vector<int64_t> signed_keys(300'000);
+		std::generate(signed_keys.begin(), signed_keys.end(), [&] { return static_cast<int64_t>(rnd_gen()); });
+		signed_keys.push_back(INT64_MIN);
+		signed_keys.push_back(INT64_MAX);
+		signed_keys.push_back(0);
+		signed_keys.push_back(-1);
+
+		std::vector<uint64_t> unsigned_keys(signed_keys.begin(), signed_keys.end());
+
+		radix_sort(signed_keys, 4);
+		radix_sort(unsigned_keys, 4);
+
+		CHECK(std::is_sorted(signed_keys.begin(), signed_keys.end()));
+		CHECK(signed_keys.front() == INT64_MIN);
+		CHECK(std::is_sorted(unsigned_keys.begin(), unsigned_keys.end()));
+	}
+
+	SECTION("payloads are sorted stably by key")
+	{
+		std::vector<std::pair<uint32_t, int>> records(200'000);
+		for (size_t i = 0; i < records.size(); ++i)
+			records[i] = {static_cast<uint32_t>(rnd_gen() % 1000), static_cast<int>(i)};
+
+		std::vector<std::pair<uint32_t, int>> expected = records;
+		std::stable_sort(expected.begin(), expected.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+		radix_sort(records, 3, [](const auto& r) { return r.first; });
+		CHECK(records == expected);
+	}
+
+	SECTION("small and degenerate inputs")
+	{
+		std::vector<short> empty;
+		radix_sort(empty);
+		CHECK(empty.empty());
+
+		std::vector<short> few{3, -1, 2, -32768, 32767};
+		radix_sort(few);
+		CHECK(few == std::vector<short>{-32768, -1, 2, 3, 32767});
+
+		std::vector<unsigned> same(100'000, 42);
+		radix_sort(same, 4);
+		CHECK(same == std::vector<unsigned>(100'000, 42));
+	}
+}
+
+TEST_CASE("external_sort")
+{
+	namespace fs = std::filesystem;
+
+	const fs::path dir = fs::temp_directory_path() / "threads_external_sort_test";
+	fs::create_directories(dir);
+	const fs::path input = dir / "input.bin";
+	const fs::path output = dir / "output.bin";
+
+	auto write_ints = [](const fs::path& path, const std::vector<int32_t>& values) {
+		std::FILE* f = std::fopen(path.string().c_str(), "wb");
+		std::fwrite(values.data(), sizeof(int32_t), values.size(), f);
+		std::fclose(f);
+	};
+
+	auto read_ints = [](const fs::path& path) {
+		std::vector<int32_t> values(fs::file_size(path) / sizeof(int32_t));
+		std::FILE* f = std::fopen(path.string().c_str(), "rb");
+		CHECK(std::fread(values.data(), sizeof(int32_t), values.size(), f) == values.size());
+		std::fclose(f);
+		return values;
+	};
+
+	std::mt19937_64 rnd_gen{665};
+	std::uniform_int_distribution<int32_t> rnd_distr(INT32_MIN, INT32_MAX);
+	std::vector<int32_t> data(500'000);
+	std::generate(data.begin(), data.end(), [&] { return rnd_distr(rnd_gen); });
+	write_ints(input, data);
+
+	std::vector<int32_t> expected = data;
+	std::sort(expected.begin(), expected.end());
+
+	ExternalSortOptions options;
+	options.temp_dir = dir;
+	options.no_of_threads = 2;
+
+	SECTION("single run fits into memory")
+	{
+		const ExternalSortStats stats = external_sort(input, output, options);
+
+		CHECK(stats.elements == data.size());
+		CHECK(stats.runs == 1);
+		CHECK(stats.merge_passes == 0);
+		CHECK(read_ints(output) == expected);
+	}
+
+	SECTION("many runs, one merge pass")
+	{
+		options.memory_bytes = 512 << 10;   // runs of 256 KiB - 8 runs
+		options.io_buffer_bytes = 16 << 10; // fan-in 31
+
+		const ExternalSortStats stats = external_sort(input, output, options);
+
+		CHECK(stats.runs == 8);
+		CHECK(stats.merge_passes == 1);
+		CHECK(stats.mb_per_second() > 0);
+		CHECK(read_ints(output) == expected);
+	}
+
+	SECTION("more runs than the fan-in need intermediate passes")
+	{
+		options.memory_bytes = 128 << 10;   // runs of 64 KiB - 31 runs
+		options.io_buffer_bytes = 24 << 10; // fan-in 4 -> 8 -> 2 -> 1
+
+		const ExternalSortStats stats = external_sort(input, output, options);
+
+		CHECK(stats.runs == 31);
+		CHECK(stats.merge_passes == 3);
+		CHECK(read_ints(output) == expected);
+	}
+
+	SECTION("empty input")
+	{
+		write_ints(input, {});
+		const ExternalSortStats stats = external_sort(input, output, options);
+
+		CHECK(stats.elements == 0);
+		CHECK(fs::file_size(output) == 0);
+	}
+
+	if (fs::exists("/dev/full")) // fails every write with ENOSPC
+	{
+		SECTION("a failed final write is an error")
+		{
+			// both outputs are small enough to stay in the stdio buffer until the file is closed
+			write_ints(input, std::vector<int32_t>(data.begin(), data.begin() + 10));
+			CHECK_THROWS_AS(external_sort(input, "/dev/full", options), std::runtime_error);
+
+			options.memory_bytes = 64;    // runs of 8
+			options.io_buffer_bytes = 16; // fan-in 3
+			CHECK_THROWS_AS(external_sort(input, "/dev/full", options), std::runtime_error);
+		}
+	}
+
+	SECTION("truncated input is rejected")
+	{
+		fs::resize_file(input, 4 * 10 + 3);
+		CHECK_THROWS_AS(external_sort(input, output, options), std::runtime_error);
+	}
+
+	// only input and output are left behind - run files are removed
+	size_t files = 0;
+	for ([[maybe_unused]] const auto& entry : fs::directory_iterator{dir})
+		++files;
+	CHECK(files <= 2);
+
+	fs::remove_all(dir);
+}
+
+TEST_CASE("pixel pipeline")
+{
+	std::mt19937_64 rnd_gen{665};
+	std::uniform_int_distribution<int32_t> rnd_distr(-1000, 1'000'000);
+	std::vector<int32_t> image(300'001);
+	std::generate(image.begin(), image.end(), [&] { return rnd_distr(rnd_gen); });
+
+	const pixel::Threshold threshold{10'000};
+	const pixel::Clamp clamp{0, 900'000};
+	const pixel::Scale scale{0.25f};
+	const pixel::Pipeline pipeline{threshold, clamp, scale};
+
+	CHECK(pipeline(5'000) == 0);
+	CHECK(pipeline(20'000) == 5'000);
+	CHECK(pipeline(999'999) == 225'000);
+
+	// reference: one std::transform per stage, then a sequential histogram
+	std::vector<int32_t> expected(image.size());
+	std::transform(image.begin(), image.end(), expected.begin(), threshold);
+	std::transform(expected.begin(), expected.end(), expected.begin(), clamp);
+	std::transform(expected.begin(), expected.end(), expected.begin(), scale);
+
+	pixel::Histogram expected_histogram{0, 250'000, 100};
+	for (int32_t p : expected)
+		expected_histogram.add(p);
+
+	SECTION("fused pass matches chained passes for any threads and tile size")
+	{
+		for (size_t threads : {1, 3, 8})
+			for (size_t tile_size : {size_t{1000}, size_t{4097}, pixel::Pipeline<>::default_tile_size})
+			{
+				std::vector<int32_t> output(image.size());
+				pixel::Histogram histogram{0, 250'000, 100};
+				pipeline.run(image, output, threads, &histogram, tile_size);
+
+				CHECK(output == expected);
+				CHECK(histogram.counts() == expected_histogram.counts());
+			}
+	}
+
+	SECTION("in place")
+	{
+		pipeline.run(image, 4);
+		CHECK(image == expected);
+	}
+
+	SECTION("histogram only")
+	{
+		const std::vector<int32_t> before = expected;
+		pixel::Histogram histogram{0, 250'000, 100};
+		pixel::Pipeline<>{}.run(expected, expected, 3, &histogram);
+
+		CHECK(expected == before);
+		CHECK(histogram.counts() == expected_histogram.counts());
+	}
+
+	SECTION("histogram bins")
+	{
+		pixel::Histogram histogram{0, 99, 10};
+		for (int32_t p : {-5, 0, 9, 10, 55, 99, 150})
+			histogram.add(p);
+
+		CHECK(histogram.counts() == std::vector<uint64_t>{3, 1, 0, 0, 0, 1, 0, 0, 0, 2});
+		CHECK_THROWS_AS((pixel::Histogram{10, 0, 4}), std::invalid_argument);
+	}
+}
+
+TEST_CASE("AsyncLogger")
+{
+	std::ostringstream out;
+
+	auto lines_of = [](const std::string& text) {
+		std::vector<std::string> lines;
+		std::istringstream in{text};
+		for (std::string line; std::getline(in, line);)
+			lines.push_back(line);
+		return lines;
+	};
+
+	SECTION("arguments are formatted like stream insertions")
+	{
+		AsyncLogger logger{out};
+		const std::string text = "string";
+		const std::string_view view = "view";
+
+		CHECK(logger.log("int ", 42, ", char ", 'c', ", double ", 0.5, ", ", text, ", ", view));
+		CHECK(logger.log());
+		logger.flush();
+
+		CHECK(out.str() == "int 42, char c, double 0.5, string, view\n\n");
+		CHECK(logger.written() == 2);
+	}
+
+	SECTION("strings are truncated to the record size")
+	{
+		AsyncLogger logger{out};
+		logger.log(std::string(1000, 'x'), 7);
+		logger.flush();
+
+		const std::string line = lines_of(out.str()).at(0);
+		CHECK(line.size() < AsyncLogger::record_size);
+		CHECK(line.back() == '7');
+	}
+
+	SECTION("records of every thread are written in order")
+	{
+		{
+			AsyncLogger logger{out, 64};
+			std::vector<std::thread> thds;
+			for (int t = 0; t < 4; ++t)
+				thds.emplace_back([&logger, t] {
+					for (int i = 0; i < 1000; ++i)
+						while (!logger.log(t, " ", i))
+							std::this_thread::yield(); // ring full - wait for the flusher
+				});
+
+			for (auto& thd : thds)
+				thd.join();
+		} // destructor writes the rest
+
+		std::vector<int> next(4, 0);
+		size_t records = 0;
+		bool in_order = true;
+		for (const auto& line : lines_of(out.str()))
+		{
+			if (line.starts_with("[AsyncLogger]"))
+				continue;
+
+			std::istringstream in{line};
+			int t, i;
+			in >> t >> i;
+			in_order = in_order && (i == next.at(t)++);
+			++records;
+		}
+		CHECK(in_order);
+		CHECK(records == 4000);
+	}
+
+	SECTION("full ring drops records")
+	{
+		AsyncLogger logger{out, 4, std::chrono::hours{1}}; // the flusher runs on flush() only
+
+		int accepted = 0;
+		for (int i = 0; i < 10; ++i)
+			accepted += logger.log("record ", i);
+		CHECK(accepted == 4);
+
+		logger.flush();
+		CHECK(logger.written() == 4);
+		CHECK(logger.dropped() == 6);
+		CHECK(out.str().starts_with("[AsyncLogger] 6 records dropped\nrecord 0\n"));
+
+		// space again after the flush
+		CHECK(logger.log("record ", 10));
+	}
+
+	SECTION("rings of exited threads are freed")
+	{
+		AsyncLogger logger{out};
+		for (int t = 0; t < 100; ++t)
+			std::thread{[&logger, t] { logger.log("thread ", t); }}.join();
+
+		logger.flush();
+		CHECK(logger.written() == 100);
+		CHECK(logger.no_of_rings() == 0);
+
+		// a thread that keeps running keeps its ring
+		logger.log("main");
+		logger.flush();
+		CHECK(logger.no_of_rings() == 1);
+		CHECK(lines_of(out.str()).size() == 101);
+	}
+}
+
+TEST_CASE("jobs")
+{
+	SECTION("interruptible_sleep_for sleeps the full duration without a stop request")
+	{
+		std::stop_source source;
+		const auto start = std::chrono::steady_clock::now();
+
+		CHECK(interruptible_sleep_for(source.get_token(), 20ms));
+		CHECK(std::chrono::steady_clock::now() - start >= 20ms);
+	}
+
+	SECTION("stop request wakes a sleeper")
+	{
+		std::stop_source source;
+		std::atomic<bool> completed = true;
+		const auto start = std::chrono::steady_clock::now();
+
+		std::thread sleeper{[&] { completed = interruptible_sleep_for(source.get_token(), 1h); }};
+		std::this_thread::sleep_for(10ms);
+		source.request_stop();
+		sleeper.join();
+
+		CHECK(!completed);
+		CHECK(std::chrono::steady_clock::now() - start < 10s);
+	}
+
+	SECTION("JobGroup stops all jobs at once")
+	{
+		std::atomic<int> started = 0;
+		std::atomic<int> cancelled = 0;
+		std::atomic<int> plain = 0;
+		const auto start = std::chrono::steady_clock::now();
+
+		{
+			JobGroup jobs;
+			for (int i = 0; i < 100; ++i)
+				jobs.spawn([&](std::stop_token stop, int step) {
+					++started;
+					while (interruptible_sleep_for(stop, step * 1h))
+					{
+					}
+					++cancelled;
+				}, 1);
+			jobs.spawn([&plain] { ++plain; }); // without a stop_token
+
+			CHECK(jobs.size() == 101);
+			while (started < 100)
+				std::this_thread::yield();
+		} // destructor: stop and join
+
+		CHECK(cancelled == 100);
+		CHECK(plain == 1);
+		CHECK(std::chrono::steady_clock::now() - start < 10s);
+	}
+}
+
+TEST_CASE("random fill")
+{
+	SECTION("BoundedIntDistribution is uniform over [a, b]")
+	{
+		SplitMix64 rnd_gen{665};
+		BoundedIntDistribution<int> die{1, 6};
+
+		std::vector<int> counts(7, 0);
+		for (int i = 0; i < 600'000; ++i)
+			++counts.at(die(rnd_gen));
+
+		CHECK(counts[0] == 0);
+		for (int face = 1; face <= 6; ++face)
+			CHECK(std::abs(counts[face] - 100'000) < 1'500); // ~5 sigma
+	}
+
+	SECTION("BoundedIntDistribution ranges")
+	{
+		SplitMix64 rnd_gen{42};
+
+		BoundedIntDistribution<int32_t> full{INT32_MIN, INT32_MAX};
+		BoundedIntDistribution<int64_t> negative{-5, -3};
+		BoundedIntDistribution<uint8_t> one{7, 7};
+		CHECK(full.b() == INT32_MAX);
+
+		bool in_range = true;
+		for (int i = 0; i < 10'000; ++i)
+		{
+			const int64_t n = negative(rnd_gen);
+			in_range = in_range && (n >= -5 && n <= -3) && (one(rnd_gen) == 7);
+			full(rnd_gen);
+		}
+		CHECK(in_range);
+
+		CHECK_THROWS_AS((BoundedIntDistribution<int>{3, 2}), std::invalid_argument);
+		CHECK_THROWS_AS((BoundedIntDistribution<int64_t>{0, int64_t{1} << 32}), std::invalid_argument);
+		CHECK_NOTHROW(BoundedIntDistribution<int64_t>{1, int64_t{1} << 32});
+	}
+
+	SECTION("parallel_fill result depends on the seed, not on the number of threads")
+	{
+		std::vector<int> single(1'000'003);
+		parallel_fill_uniform(single, 0, 1'000'000, 665, 1);
+
+		CHECK(std::all_of(single.begin(), single.end(), [](int x) { return x >= 0 && x <= 1'000'000; }));
+		CHECK(std::count(single.begin(), single.end(), single[0]) < 10);
+
+		for (size_t threads : {2, 5})
+		{
+			std::vector<int> parallel(single.size());
+			parallel_fill_uniform(parallel, 0, 1'000'000, 665, threads);
+			CHECK(parallel == single);
+		}
+
+		std::vector<int> other_seed(single.size());
+		parallel_fill_uniform(other_seed, 0, 1'000'000, 666);
+		CHECK(other_seed != single);
+	}
+
+	SECTION("parallel_fill with a custom generator")
+	{
+		std::vector<double> data(100'000);
+		parallel_fill(data, 1, [](SplitMix64& rnd_gen) { return static_cast<double>(rnd_gen() >> 11) * 0x1.0p-53; }, 3);
+
+		CHECK(std::all_of(data.begin(), data.end(), [](double x) { return x >= 0.0 && x < 1.0; }));
+	}
+}
+
+TEST_CASE("pipeline queues")
+{
+	SECTION("SPSC and MPMC queues are bounded FIFOs")
+	{
+		pipeline::SpscQueue<int> spsc{3};
+		pipeline::MpmcQueue<int> mpmc{3};
+		REQUIRE(spsc.capacity() == 4);
+		REQUIRE(mpmc.capacity() == 4);
+
+		for (int i = 0; i < 4; ++i)
+		{
+			CHECK(spsc.try_push(i));
+			CHECK(mpmc.try_push(i));
+		}
+		int extra = 4;
+		CHECK(!spsc.try_push(extra));
+		CHECK(!mpmc.try_push(extra));
+		CHECK(spsc.size() == 4);
+		CHECK(mpmc.size() == 4);
+
+		for (int i = 0; i < 4; ++i)
+		{
+			int a = -1, b = -1;
+			CHECK((spsc.try_pop(a) && a == i));
+			CHECK((mpmc.try_pop(b) && b == i));
+		}
+		int none;
+		CHECK(!spsc.try_pop(none));
+		CHECK(!mpmc.try_pop(none));
+	}
+
+	SECTION("MPMC queue with concurrent producers and consumers")
+	{
+		pipeline::MpmcQueue<int> queue{16};
+		constexpr int per_producer = 20'000;
+		std::atomic<long long> sum = 0;
+		std::atomic<int> popped = 0;
+
+		std::vector<std::thread> thds;
+		for (int p = 0; p < 3; ++p)
+			thds.emplace_back([&queue] {
+				for (int i = 1; i <= per_producer; ++i)
+					while (!queue.try_push(i))
+						std::this_thread::yield();
+			});
+		for (int c = 0; c < 3; ++c)
+			thds.emplace_back([&] {
+				while (popped < 3 * per_producer)
+				{
+					if (int item; queue.try_pop(item))
+					{
+						sum += item;
+						++popped;
+					}
+					else
+						std::this_thread::yield();
+				}
+			});
+		for (auto& thd : thds)
+			thd.join();
+
+		CHECK(sum == 3LL * per_producer * (per_producer + 1) / 2);
+	}
+}
+
+TEST_CASE("pipeline")
+{
+	auto numbers = [](size_t n) {
+		return [n](size_t i) -> std::optional<int> {
+			if (i >= n)
+				return std::nullopt;
+			return static_cast<int>(i);
+		};
+	};
+
+	SECTION("every item passes every stage once")
+	{
+		for (size_t parallelism : {1, 3})
+		{
+			std::mutex mtx;
+			std::vector<long long> results;
+
+			pipeline::Builder builder{4};
+			builder.source("numbers", parallelism, numbers(10'000))
+				.then("square", parallelism, [](int x) { return static_cast<long long>(x) * x; })
+				.then("to string", 2, [](long long x) { return std::to_string(x); })
+				.sink("collect", parallelism, [&](std::string x) {
+					std::lock_guard lk{mtx};
+					results.push_back(std::stoll(x));
+				});
+
+			const pipeline::Stats stats = builder.run();
+
+			std::sort(results.begin(), results.end());
+			std::vector<long long> expected(10'000);
+			for (size_t i = 0; i < expected.size(); ++i)
+				expected[i] = static_cast<long long>(i * i);
+			CHECK(results == expected);
+
+			REQUIRE(stats.stages.size() == 4);
+			CHECK(stats.stages[0].name == "numbers");
+			CHECK(stats.stages[3].name == "collect");
+			for (const auto& stage : stats.stages)
+			{
+				CHECK(stage.items == 10'000);
+				CHECK(stage.max_input_occupancy <= stage.input_capacity);
+			}
+		}
+	}
+
+	SECTION("a slow consumer blocks the producer - backpressure")
+	{
+		pipeline::Builder builder{2};
+		builder.source("fast", 1, numbers(50))
+			.sink("slow", 1, [](int) { std::this_thread::sleep_for(1ms); });
+
+		const pipeline::Stats stats = builder.run();
+
+		CHECK(stats.stages[0].output_wait_seconds > 0.02);
+		CHECK(stats.stages[1].max_input_occupancy <= 2);
+	}
+
+	SECTION("exception in a stage stops the pipeline and is rethrown")
+	{
+		pipeline::Builder builder{2};
+		builder.source("endless", 1, [](size_t i) -> std::optional<size_t> { return i; })
+			.then("fails", 2, [](size_t i) {
+				if (i == 100)
+					throw std::runtime_error("stage failed");
+				return i;
+			})
+			.sink("ignore", 1, [](size_t) {});
+
+		CHECK_THROWS_AS(builder.run(), std::runtime_error);
+	}
+
+	SECTION("pipeline without a sink")
+	{
+		pipeline::Builder builder;
+		builder.source("numbers", 1, numbers(10));
+
+		CHECK_THROWS_AS(builder.run(), std::logic_error);
+	}
+
+	SECTION("a pipeline runs once")
+	{
+		std::atomic<size_t> consumed = 0;
+		pipeline::Builder builder;
+		builder.source("numbers", 1, numbers(10))
+			.sink("count", 1, [&](int) { ++consumed; });
+
+		CHECK(builder.run().stages.size() == 2);
+		CHECK_THROWS_AS(builder.run(), std::logic_error);
+		CHECK(consumed == 10);
+	}
+}
+
+TEST_CASE("selection")
+{
+	std::vector<int> data(500'001);
+	parallel_fill_uniform(data, 0, 100'000, 665); // with duplicates
+
+	std::vector<int> sorted = data;
+	std::sort(sorted.begin(), sorted.end());
+
+	SECTION("parallel_top_k")
+	{
+		for (size_t threads : {1, 4})
+		{
+			const std::vector<int> top = parallel_top_k(data, 1000, threads);
+			CHECK(top == std::vector<int>(sorted.rbegin(), sorted.rbegin() + 1000));
+
+			const std::vector<int> bottom = parallel_top_k(data, 10, threads, std::less<>{});
+			CHECK(bottom == std::vector<int>(sorted.begin(), sorted.begin() + 10));
+		}
+
+		CHECK(parallel_top_k(data, 0).empty());
+		CHECK(parallel_top_k(std::vector<int>{3, 1, 2}, 10) == std::vector<int>{3, 2, 1});
+	}
+
+	SECTION("parallel_nth_element")
+	{
+		for (size_t n : {size_t{0}, size_t{1}, data.size() / 2, data.size() - 1})
+			for (size_t threads : {1, 4})
+			{
+				std::vector<int> v = data;
+				parallel_nth_element(v, n, threads);
+
+				REQUIRE(v[n] == sorted[n]);
+				CHECK(std::all_of(v.begin(), v.begin() + n, [&](int x) { return x <= v[n]; }));
+				CHECK(std::all_of(v.begin() + n, v.end(), [&](int x) { return x >= v[n]; }));
+
+				std::sort(v.begin(), v.end());
+				CHECK(v == sorted);
+			}
+	}
+
+	SECTION("parallel_nth_element with few distinct values")
+	{
+		std::vector<int> v(300'000);
+		for (size_t i = 0; i < v.size(); ++i)
+			v[i] = static_cast<int>(i % 3);
+
+		parallel_nth_element(v, 150'000, 4);
+		CHECK(v[150'000] == 1);
+	}
+
+	SECTION("parallel_partial_sort")
+	{
+		for (size_t k : {size_t{1}, size_t{1000}, size_t{200'000}, data.size()})
+		{
+			std::vector<int> v = data;
+			parallel_partial_sort(v, k, 4);
+			CHECK(std::equal(v.begin(), v.begin() + k, sorted.begin()));
+		}
+
+		std::vector<int> descending = data;
+		parallel_partial_sort(descending, 100, 3, std::greater<>{});
+		CHECK(std::equal(descending.begin(), descending.begin() + 100, sorted.rbegin()));
+	}
+}
@@ -0,0 +1,147 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Fixed number of worker threads fed from a bounded FIFO queue.
+// - submit() returns a std::future - the result or the exception thrown by the task arrives through it
+// - when max_queue_size tasks are waiting, submit() blocks until a worker takes one (backpressure);
+//   try_submit() returns std::nullopt instead
+// - shutdown() (and the destructor) stop accepting tasks, run everything already queued and join the workers
+class ThreadPool
+{
+	using Task = std::function<void()>;
+
+	std::vector<std::thread> threads_;
+	std::queue<Task> tasks_;
+	const size_t max_queue_size_;
+	bool stopping_ = false;
+
+	std::mutex mtx_;
+	std::condition_variable cv_not_empty_;
+	std::condition_variable cv_not_full_;
+
+	void run()
+	{
+		while (true)
+		{
+			Task task;
+			{
+				std::unique_lock lk{mtx_};
+				cv_not_empty_.wait(lk, [this] { return !tasks_.empty() || stopping_; });
+
+				if (tasks_.empty()) // stopping and drained
+					return;
+
+				task = std::move(tasks_.front());
+				tasks_.pop();
+			}
+			cv_not_full_.notify_one();
+
+			task(); // exceptions are captured by the packaged_task
+		}
+	}
+
+	template <typename F, typename... Args>
+	static auto make_task(F&& f, Args&&... args)
+	{
+		using Result = std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>;
+
+		// packaged_task is move-only and std::function needs a copyable target - hence the shared_ptr
+		auto task = std::make_shared<std::packaged_task<Result()>>(
+			[f = std::forward<F>(f), ... args = std::forward<Args>(args)]() mutable { return std::invoke(std::move(f), std::move(args)...); });
+
+		return std::pair{std::function<void()>{[task] { (*task)(); }}, task->get_future()};
+	}
+
+public:
+	explicit ThreadPool(size_t no_of_threads = std::max(1u, std::thread::hardware_concurrency()), size_t max_queue_size = 1024)
+		: max_queue_size_{std::max<size_t>(max_queue_size, 1)}
+	{
+		no_of_threads = std::max<size_t>(no_of_threads, 1);
+
+		threads_.reserve(no_of_threads);
+		for (size_t i = 0; i < no_of_threads; ++i)
+			threads_.emplace_back([this] { run(); });
+	}
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	~ThreadPool()
+	{
+		shutdown();
+	}
+
+	size_t size() const
+	{
+		return threads_.size();
+	}
+
+	// blocks while the queue is full; throws std::runtime_error after shutdown()
+	template <typename F, typename... Args>
+	auto submit(F&& f, Args&&... args)
+	{
+		auto [task, result] = make_task(std::forward<F>(f), std::forward<Args>(args)...);
+		{
+			std::unique_lock lk{mtx_};
+			cv_not_full_.wait(lk, [this] { return tasks_.size() < max_queue_size_ || stopping_; });
+
+			if (stopping_)
+				throw std::runtime_error("ThreadPool: submit after shutdown");
+
+			tasks_.push(std::move(task));
+		}
+		cv_not_empty_.notify_one();
+
+		return std::move(result);
+	}
+
+	// std::nullopt if the queue is full; throws std::runtime_error after shutdown()
+	template <typename F, typename... Args>
+	auto try_submit(F&& f, Args&&... args) -> std::optional<std::future<std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>>>
+	{
+		auto [task, result] = make_task(std::forward<F>(f), std::forward<Args>(args)...);
+		{
+			std::lock_guard lk{mtx_};
+
+			if (stopping_)
+				throw std::runtime_error("ThreadPool: submit after shutdown");
+			if (tasks_.size() >= max_queue_size_)
+				return std::nullopt;
+
+			tasks_.push(std::move(task));
+		}
+		cv_not_empty_.notify_one();
+
+		return std::move(result);
+	}
+
+	// runs all queued tasks, then joins the workers; idempotent
+	void shutdown()
+	{
+		{
+			std::lock_guard lk{mtx_};
+			stopping_ = true;
+		}
+		cv_not_empty_.notify_all();
+		cv_not_full_.notify_all();
+
+		for (auto& thd : threads_)
+			if (thd.joinable())
+				thd.join();
+	}
+};
+
+#endif
@@ -0,0 +1,573 @@
+#ifndef ALLOCATOR_BENCH_HPP
+#define ALLOCATOR_BENCH_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <latch>
+#include <list>
+#include <map>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <ostream>
+#include <semaphore>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+#include "arena.hpp"
+#include "bench.hpp"
+#include "node_pool.hpp"
+#include "thread_arena.hpp"
+
+// Allocator benchmark suite: every workload (a node-based or growing container filled, half emptied and destroyed)
+// runs through every memory resource configuration, single-threaded and with several threads at once.
+// Reported per case: time per workload run, allocation throughput (allocate + deallocate pairs per second)
+// and the peak resident set size the case added to the process.
+namespace alloc_bench
+{
+	//////////////////////////////////////////////////////////////////////////////
+	// instrumentation
+
+	// forwards to upstream and counts - used once per workload to know how many allocations a run makes
+	class CountingResource : public std::pmr::memory_resource
+	{
+		std::pmr::memory_resource* upstream_;
+		size_t allocations_ = 0;
+		size_t deallocations_ = 0;
+		size_t bytes_ = 0;
+
+	public:
+		explicit CountingResource(std::pmr::memory_resource* upstream = std::pmr::new_delete_resource()) : upstream_{upstream} {}
+
+		size_t allocations() const { return allocations_; }
+		size_t deallocations() const { return deallocations_; }
+		size_t bytes() const { return bytes_; }
+
+	protected:
+		void* do_allocate(size_t bytes, size_t alignment) override
+		{
+			++allocations_;
+			bytes_ += bytes;
+			return upstream_->allocate(bytes, alignment);
+		}
+
+		void do_deallocate(void* p, size_t bytes, size_t alignment) override
+		{
+			++deallocations_;
+			upstream_->deallocate(p, bytes, alignment);
+		}
+
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+		{
+			return this == &other;
+		}
+	};
+
+	// Linux: VmRSS / VmHWM of /proc/self/status; 0 where unavailable
+	inline size_t status_kb(const std::string& key)
+	{
+		std::ifstream status{"/proc/self/status"};
+		for (std::string line; std::getline(status, line);)
+			if (line.compare(0, key.size(), key) == 0 && line.size() > key.size() && line[key.size()] == ':')
+				return std::stoul(line.substr(key.size() + 1));
+		return 0;
+	}
+
+	inline size_t current_rss_bytes()
+	{
+		return status_kb("VmRSS") * 1024;
+	}
+
+	inline size_t peak_rss_bytes()
+	{
+		return status_kb("VmHWM") * 1024;
+	}
+
+	// returns free heap memory to the OS (glibc) and restarts peak tracking from the current RSS (Linux 4.0+)
+	inline void reset_peak_rss()
+	{
+#if defined(__GLIBC__)
+		malloc_trim(0);
+#endif
+		std::ofstream{"/proc/self/clear_refs"} << "5";
+	}
+
+	//////////////////////////////////////////////////////////////////////////////
+	// workloads
+
+	struct Workload
+	{
+		std::string name;
+		std::function<void(std::pmr::memory_resource*, size_t)> run; // (resource, no_of_elements)
+		size_t no_of_elements;
+	};
+
+	inline std::vector<Workload> workloads()
+	{
+		return {
+			{"pmr::map<int, int>",
+				[](std::pmr::memory_resource* mr, size_t n) {
+					std::pmr::map<int, int> m{mr};
+					for (size_t i = 0; i < n; ++i)
+						m.emplace(static_cast<int>(i * 7919 % n), static_cast<int>(i));
+					for (size_t i = 0; i < n; i += 2)
+						m.erase(static_cast<int>(i));
+					bench::do_not_optimize(m);
+				},
+				20'000},
+			{"pmr::list<int>",
+				[](std::pmr::memory_resource* mr, size_t n) {
+					std::pmr::list<int> l{mr};
+					for (size_t i = 0; i < n; ++i)
+						l.push_back(static_cast<int>(i));
+					size_t index = 0;
+					l.remove_if([&](int) { return index++ % 2 == 0; });
+					bench::do_not_optimize(l);
+				},
+				20'000},
+			{"pmr::unordered_map<int, int>",
+				[](std::pmr::memory_resource* mr, size_t n) {
+					std::pmr::unordered_map<int, int> m{mr};
+					for (size_t i = 0; i < n; ++i)
+						m.emplace(static_cast<int>(i), static_cast<int>(i));
+					for (size_t i = 0; i < n; i += 2)
+						m.erase(static_cast<int>(i));
+					bench::do_not_optimize(m);
+				},
+				20'000},
+			{"pmr::vector<pmr::string>",
+				[](std::pmr::memory_resource* mr, size_t n) {
+					std::pmr::vector<std::pmr::string> v{mr};
+					for (size_t i = 0; i < n; ++i)
+						v.emplace_back(48, static_cast<char>('a' + i % 26)); // longer than the small string buffer
+					size_t index = 0;
+					std::erase_if(v, [&](const auto&) { return index++ % 2 == 0; });
+					bench::do_not_optimize(v);
+				},
+				20'000},
+			{"pmr::deque<int>",
+				[](std::pmr::memory_resource* mr, size_t n) {
+					std::pmr::deque<int> d{mr};
+					for (size_t i = 0; i < n; ++i)
+						d.push_back(static_cast<int>(i));
+					for (size_t i = 0; i < n / 2; ++i)
+						d.pop_front();
+					for (size_t i = 0; i < n / 2; ++i)
+						d.push_back(static_cast<int>(i));
+					bench::do_not_optimize(d);
+				},
+				200'000},
+		};
+	}
+
+	//////////////////////////////////////////////////////////////////////////////
+	// memory resource configurations
+
+	// resource() serves workload runs; end_run() is called after each run - arenas drop everything there
+	struct Allocator
+	{
+		std::shared_ptr<std::pmr::memory_resource> resource;
+		std::function<void()> end_run = [] {};
+	};
+
+	struct Config
+	{
+		std::string name;
+		bool thread_safe; // one instance may serve all threads; otherwise every thread gets its own
+		std::function<Allocator()> make;
+	};
+
+	inline std::vector<Config> configs()
+	{
+		using namespace std::pmr;
+
+		return {
+			{"new_delete", true,
+				[] {
+					return Allocator{std::shared_ptr<memory_resource>{new_delete_resource(), [](memory_resource*) {}}};
+				}},
+			{"monotonic", false,
+				[] {
+					auto mbr = std::make_shared<monotonic_buffer_resource>();
+					return Allocator{mbr, [mbr = mbr.get()] { mbr->release(); }};
+				}},
+			{"arena (reset)", false,
+				[] {
+					auto arena = std::make_shared<ArenaResource>();
+					return Allocator{arena, [arena = arena.get()] { arena->reset(); }};
+				}},
+			{"unsync pool", false,
+				[] {
+					return Allocator{std::make_shared<unsynchronized_pool_resource>()};
+				}},
+			{"unsync pool on arena", false,
+				[] {
+					auto arena = std::make_shared<ArenaResource>();
+					auto pool = std::shared_ptr<unsynchronized_pool_resource>{
+						new unsynchronized_pool_resource{arena.get()}, [arena](unsynchronized_pool_resource* p) { delete p; }};
+					return Allocator{pool, [pool = pool.get(), arena = arena.get()] {
+						pool->release();
+						arena->reset();
+					}};
+				}},
+			{"sync pool", true,
+				[] {
+					return Allocator{std::make_shared<synchronized_pool_resource>()};
+				}},
+			{"node pool", true,
+				[] {
+					return Allocator{std::make_shared<NodePoolResource>()};
+				}},
+		};
+	}
+
+	//////////////////////////////////////////////////////////////////////////////
+	// running
+
+	struct CaseResult
+	{
+		std::string workload;
+		std::string config;
+		size_t no_of_threads;
+		bench::Result time;          // per workload run (multi-threaded: wall time of one run on every thread)
+		double allocs_per_second;    // allocate + deallocate pairs, all threads
+		size_t peak_rss_bytes;       // peak RSS over the case minus RSS before it
+	};
+
+	inline size_t allocations_per_run(const Workload& workload)
+	{
+		CountingResource counter;
+		workload.run(&counter, workload.no_of_elements);
+		return counter.allocations();
+	}
+
+	inline CaseResult run_single_threaded(const Workload& workload, const Config& config, size_t allocations)
+	{
+		reset_peak_rss();
+		const size_t rss_before = current_rss_bytes();
+
+		Allocator allocator = config.make();
+		bench::Options options;
+		options.samples = 10;
+		bench::Result time = bench::run(config.name, [&] {
+			workload.run(allocator.resource.get(), workload.no_of_elements);
+			allocator.end_run();
+		}, options);
+
+		const size_t peak = peak_rss_bytes();
+		return {workload.name, config.name, 1, time, static_cast<double>(allocations) / time.median,
+			peak > rss_before ? peak - rss_before : 0};
+	}
+
+	// every thread runs the workload runs_per_sample times per sample; a sample is the wall time of
+	// one such round divided by runs_per_sample
+	inline CaseResult run_multi_threaded(const Workload& workload, const Config& config, size_t allocations,
+		size_t no_of_threads, size_t samples = 7, size_t runs_per_sample = 8)
+	{
+		reset_peak_rss();
+		const size_t rss_before = current_rss_bytes();
+
+		std::vector<Allocator> allocators;
+		allocators.push_back(config.make());
+		for (size_t t = 1; t < no_of_threads; ++t)
+			allocators.push_back(config.thread_safe ? allocators.front() : config.make());
+
+		std::vector<double> times;
+		for (size_t s = 0; s < samples; ++s)
+		{
+			std::latch start{static_cast<std::ptrdiff_t>(no_of_threads + 1)};
+			std::vector<std::thread> thds;
+			for (size_t t = 0; t < no_of_threads; ++t)
+				thds.emplace_back([&, t] {
+					start.arrive_and_wait();
+					for (size_t r = 0; r < runs_per_sample; ++r)
+					{
+						workload.run(allocators[t].resource.get(), workload.no_of_elements);
+						if (!config.thread_safe)
+							allocators[t].end_run();
+					}
+				});
+
+			times.push_back(bench::time_once([&] {
+				start.arrive_and_wait();
+				for (auto& thd : thds)
+					thd.join();
+			}) / static_cast<double>(runs_per_sample));
+		}
+
+		bench::Result time = bench::analyze(config.name, std::move(times), runs_per_sample);
+		const size_t peak = peak_rss_bytes();
+		return {workload.name, config.name, no_of_threads, time,
+			static_cast<double>(allocations * no_of_threads) / time.median, peak > rss_before ? peak - rss_before : 0};
+	}
+
+	// allocate + deallocate pairs per second on no_of_threads threads sharing resource: every thread allocates
+	// a batch of nodes, frees it in reverse order and repeats - the pattern of node containers growing and shrinking
+	inline double alloc_free_throughput(std::pmr::memory_resource& resource, size_t no_of_threads,
+		size_t node_size = 32, size_t batch = 1024, size_t rounds = 500)
+	{
+		std::latch start{static_cast<std::ptrdiff_t>(no_of_threads + 1)};
+		std::vector<std::thread> thds;
+		for (size_t t = 0; t < no_of_threads; ++t)
+			thds.emplace_back([&] {
+				std::vector<void*> nodes(batch);
+				start.arrive_and_wait();
+				for (size_t r = 0; r < rounds; ++r)
+				{
+					for (auto& node : nodes)
+						node = resource.allocate(node_size, alignof(std::max_align_t));
+					bench::clobber_memory();
+					for (size_t i = batch; i-- > 0;)
+						resource.deallocate(nodes[i], node_size, alignof(std::max_align_t));
+				}
+			});
+
+		const double seconds = bench::time_once([&] {
+			start.arrive_and_wait();
+			for (auto& thd : thds)
+				thd.join();
+		});
+
+		return static_cast<double>(no_of_threads * rounds * batch) / seconds;
+	}
+
+	// alloc_free_throughput of the thread-safe configurations at 1..max_threads threads
+	inline void run_scaling(std::ostream& out, size_t max_threads)
+	{
+		out << "\nalloc/free throughput of a shared resource (M pairs/s)\n";
+		out << std::setw(22) << std::left << "  threads:" << std::right;
+		for (size_t threads = 1; threads <= max_threads; ++threads)
+			out << std::setw(8) << threads;
+		out << "\n";
+
+		for (const auto& config : configs())
+		{
+			if (!config.thread_safe)
+				continue;
+
+			Allocator allocator = config.make();
+			alloc_free_throughput(*allocator.resource, 1); // warm-up: slabs, pool chunks, heap
+
+			out << "  " << std::setw(20) << std::left << config.name << std::right;
+			for (size_t threads = 1; threads <= max_threads; ++threads)
+				out << std::setw(8) << std::fixed << std::setprecision(1) << alloc_free_throughput(*allocator.resource, threads) / 1e6;
+			out << "\n";
+		}
+	}
+
+	inline std::ostream& operator<<(std::ostream& out, const CaseResult& r)
+	{
+		out << std::left << std::setw(22) << r.config << std::right
+			<< " threads: " << r.no_of_threads
+			<< "  time/run: " << std::setw(9) << bench::format_duration(r.time.median)
+			<< "  allocs/s: " << std::fixed << std::setprecision(1) << std::setw(7) << r.allocs_per_second / 1e6 << "M"
+			<< "  peak RSS: +" << std::setprecision(1) << std::setw(6) << static_cast<double>(r.peak_rss_bytes) / (1 << 20) << " MiB";
+		return out;
+	}
+
+	// runs every workload under every configuration - single-threaded, then on no_of_threads threads -
+	// and prints one table per workload with the speedup over new_delete
+	inline std::vector<CaseResult> run_suite(std::ostream& out, size_t no_of_threads)
+	{
+		std::vector<CaseResult> results;
+		const auto all_configs = configs();
+
+		for (const auto& workload : workloads())
+		{
+			const size_t allocations = allocations_per_run(workload);
+			out << "\n" << workload.name << " - " << workload.no_of_elements << " elements, "
+				<< allocations << " allocations per run\n";
+
+			for (size_t threads : {size_t{1}, no_of_threads})
+			{
+				double baseline = 0;
+				for (const auto& config : all_configs)
+				{
+					CaseResult r = (threads == 1) ? run_single_threaded(workload, config, allocations)
+												  : run_multi_threaded(workload, config, allocations, threads);
+					if (baseline == 0)
+						baseline = r.allocs_per_second;
+
+					out << "  " << r << "  speedup: " << std::setprecision(2) << r.allocs_per_second / baseline << "\n";
+					results.push_back(std::move(r));
+				}
+			}
+		}
+
+		return results;
+	}
+
+	//////////////////////////////////////////////////////////////////////////////
+	// request loop
+
+	// runs one job at a time on its own thread - the other side of the cross-thread frees in the request loop
+	class Helper
+	{
+		std::binary_semaphore posted_{0};
+		std::binary_semaphore done_{0};
+		std::function<void()> job_;
+		bool stop_ = false;
+		std::thread thd_;
+
+	public:
+		Helper()
+			: thd_{[this] {
+				  while (true)
+				  {
+					  posted_.acquire();
+					  if (stop_)
+						  return;
+					  job_();
+					  done_.release();
+				  }
+			  }}
+		{
+		}
+
+		Helper(const Helper&) = delete;
+		Helper& operator=(const Helper&) = delete;
+
+		~Helper()
+		{
+			stop_ = true;
+			posted_.release();
+			thd_.join();
+		}
+
+		void post(std::function<void()> job)
+		{
+			job_ = std::move(job);
+			posted_.release();
+		}
+
+		void wait()
+		{
+			done_.acquire();
+		}
+	};
+
+	// One request: tokenize a synthetic text into strings, hand every other token to the helper thread, which
+	// frees them (cross-thread deallocation), count the remaining words in a hash map and format a response.
+	// Every allocation goes through mr; the request waits for the helper before it returns.
+	inline size_t handle_request(std::pmr::memory_resource* mr, Helper& helper, size_t request_no)
+	{
+		constexpr size_t no_of_tokens = 256;
+
+		std::pmr::vector<std::pmr::string> tokens{mr};
+		tokens.reserve(no_of_tokens);
+		for (size_t i = 0; i < no_of_tokens; ++i)
+			tokens.emplace_back(20 + (i * 7 + request_no) % 40, static_cast<char>('a' + (i * 13 + request_no) % 26));
+
+		std::optional<std::pmr::vector<std::pmr::string>> handed_off{std::in_place, mr};
+		handed_off->reserve(no_of_tokens / 2);
+		for (size_t i = 1; i < no_of_tokens; i += 2)
+			handed_off->push_back(std::move(tokens[i]));
+		helper.post([&] { handed_off.reset(); });
+
+		std::pmr::unordered_map<std::string_view, int> counts{mr};
+		for (size_t i = 0; i < no_of_tokens; i += 2)
+			++counts[tokens[i]];
+
+		std::pmr::string response{mr};
+		for (const auto& [word, count] : counts)
+		{
+			response += word;
+			response += ':';
+			response += std::to_string(count);
+			response += '\n';
+		}
+
+		helper.wait();
+		return response.size();
+	}
+
+	struct RequestConfig
+	{
+		std::string name;
+		std::function<void(const std::function<void(std::pmr::memory_resource*)>&)> serve; // calls handle(mr) for one request
+	};
+
+	// allocation strategies for the request loop - the per-request ones create or rewind their resource
+	// around every request
+	inline std::vector<RequestConfig> request_configs()
+	{
+		auto sync_pool = std::make_shared<std::pmr::synchronized_pool_resource>();
+		auto node_pool = std::make_shared<NodePoolResource>();
+
+		return {
+			{"new_delete", [](const auto& handle) { handle(std::pmr::new_delete_resource()); }},
+			{"sync pool (shared)", [sync_pool](const auto& handle) { handle(sync_pool.get()); }},
+			{"node pool (shared)", [node_pool](const auto& handle) { handle(node_pool.get()); }},
+			{"monotonic per request",
+				[](const auto& handle) {
+					std::pmr::monotonic_buffer_resource mbr{64 * 1024};
+					handle(&mbr);
+				}},
+			{"thread arena + scope",
+				[](const auto& handle) {
+					ThreadArena::Scope scope;
+					handle(&ThreadArena::local());
+				}},
+		};
+	}
+
+	// no_of_threads workers (each with a helper thread) serve requests_per_thread requests each;
+	// prints requests per second and the peak RSS the case added
+	inline void run_request_loop(std::ostream& out, size_t no_of_threads, size_t requests_per_thread = 500, size_t samples = 5)
+	{
+		out << "\nrequest loop - " << no_of_threads << " workers, each with a helper thread freeing half of the tokens\n";
+
+		double baseline = 0;
+		for (const auto& [name, serve] : request_configs())
+		{
+			reset_peak_rss();
+			const size_t rss_before = current_rss_bytes();
+
+			std::vector<double> times;
+			for (size_t s = 0; s < samples; ++s)
+			{
+				std::latch start{static_cast<std::ptrdiff_t>(no_of_threads + 1)};
+				std::vector<std::thread> thds;
+				for (size_t t = 0; t < no_of_threads; ++t)
+					thds.emplace_back([&] {
+						Helper helper;
+						size_t checksum = 0;
+						start.arrive_and_wait();
+						for (size_t r = 0; r < requests_per_thread; ++r)
+							serve([&](std::pmr::memory_resource* mr) { checksum += handle_request(mr, helper, r); });
+						bench::do_not_optimize(checksum);
+					});
+
+				times.push_back(bench::time_once([&] {
+					start.arrive_and_wait();
+					for (auto& thd : thds)
+						thd.join();
+				}) / static_cast<double>(no_of_threads * requests_per_thread));
+			}
+
+			const bench::Result time = bench::analyze(name, std::move(times));
+			const size_t peak = peak_rss_bytes();
+			if (baseline == 0)
+				baseline = time.median;
+
+			out << "  " << std::left << std::setw(22) << name << std::right
+				<< "  time/request: " << std::setw(9) << bench::format_duration(time.median)
+				<< "  requests/s: " << std::fixed << std::setprecision(0) << std::setw(8) << 1 / time.median
+				<< "  peak RSS: +" << std::setprecision(1) << std::setw(6) << static_cast<double>(peak > rss_before ? peak - rss_before : 0) / (1 << 20) << " MiB"
+				<< "  speedup: " << std::setprecision(2) << baseline / time.median << "\n";
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,123 @@
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+// Bump allocator for memory with a common lifetime (one request, one frame, one benchmark run):
+// allocate() moves a pointer, deallocate() does nothing and reset() drops everything at once.
+// Unlike std::pmr::monotonic_buffer_resource::release(), reset() keeps the memory - when the last run needed
+// several chunks they are replaced by one chunk of their total size, so a steady workload stops calling upstream.
+// Not thread-safe.
+class ArenaResource : public std::pmr::memory_resource
+{
+	struct Chunk
+	{
+		std::byte* data;
+		size_t size;
+	};
+
+	std::pmr::memory_resource* upstream_;
+	size_t next_chunk_size_;
+	std::vector<Chunk> chunks_;
+	std::byte* pos_ = nullptr;
+	std::byte* end_ = nullptr;
+
+public:
+	explicit ArenaResource(size_t initial_size = 64 * 1024, std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+		: upstream_{upstream}, next_chunk_size_{std::max<size_t>(initial_size, 1024)}
+	{
+	}
+
+	ArenaResource(const ArenaResource&) = delete;
+	ArenaResource& operator=(const ArenaResource&) = delete;
+
+	~ArenaResource() override
+	{
+		free_chunks();
+	}
+
+	// everything allocated so far becomes invalid
+	void reset()
+	{
+		if (chunks_.size() > 1)
+		{
+			const size_t total = capacity();
+			free_chunks();
+			add_chunk(total);
+		}
+
+		if (!chunks_.empty())
+		{
+			pos_ = chunks_.front().data;
+			end_ = pos_ + chunks_.front().size;
+		}
+	}
+
+	// bytes obtained from upstream
+	size_t capacity() const
+	{
+		size_t total = 0;
+		for (const auto& chunk : chunks_)
+			total += chunk.size;
+		return total;
+	}
+
+	std::pmr::memory_resource* upstream_resource() const
+	{
+		return upstream_;
+	}
+
+protected:
+	void* do_allocate(size_t bytes, size_t alignment) override
+	{
+		if (void* p = bump(bytes, alignment))
+			return p;
+
+		add_chunk(std::max(next_chunk_size_, bytes + alignment));
+		next_chunk_size_ *= 2;
+		return bump(bytes, alignment);
+	}
+
+	void do_deallocate(void*, size_t, size_t) override
+	{
+	}
+
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+	{
+		return this == &other;
+	}
+
+private:
+	void* bump(size_t bytes, size_t alignment)
+	{
+		const auto address = reinterpret_cast<uintptr_t>(pos_);
+		const uintptr_t aligned = (address + alignment - 1) & ~(uintptr_t{alignment} - 1);
+		if (pos_ == nullptr || aligned + bytes > reinterpret_cast<uintptr_t>(end_))
+			return nullptr;
+
+		pos_ = reinterpret_cast<std::byte*>(aligned + bytes);
+		return reinterpret_cast<void*>(aligned);
+	}
+
+	void add_chunk(size_t size)
+	{
+		auto* data = static_cast<std::byte*>(upstream_->allocate(size, alignof(std::max_align_t)));
+		chunks_.push_back({data, size});
+		pos_ = data;
+		end_ = data + size;
+	}
+
+	void free_chunks()
+	{
+		for (const auto& chunk : chunks_)
+			upstream_->deallocate(chunk.data, chunk.size, alignof(std::max_align_t));
+		chunks_.clear();
+		pos_ = end_ = nullptr;
+	}
+};
+
+#endif
@@ -0,0 +1,351 @@
+#ifndef NODE_POOL_HPP
+#define NODE_POOL_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <unordered_set>
+#include <vector>
+
+// Thread-safe pool for small fixed-size blocks - the nodes of std::pmr::list, map, set, unordered_map.
+// Requests are rounded up to size classes of 16 bytes (up to max_node_size); larger or over-aligned requests
+// go to upstream, which must then be thread-safe (the default new_delete_resource is).
+//
+// Every size class has a lock-free free list (Treiber stack) of batches - chains of up to batch_size nodes -
+// refilled from slabs taken from upstream (only a refill takes a lock). In front of it every thread keeps
+// a cache of up to 2 * batch_size free nodes per class, so allocate and deallocate are a few loads and stores,
+// and one CAS moves a whole batch between the cache and the shared list. A node freed on another thread than
+// the one that allocated it simply goes to that thread's cache. A thread caches nodes of up to 4 pools at once;
+// containers on further pools use the shared lists directly (a CAS or two per node, still lock-free).
+//
+// The free list head is a tagged pointer: the upper 16 bits of the 64-bit word count modifications, so a pop
+// that read a head which was popped and pushed back in between (ABA) fails its CAS instead of installing a stale next.
+// Memory returns to upstream only when the pool is destroyed; a thread returns its cached nodes when it exits.
+class NodePoolResource : public std::pmr::memory_resource
+{
+public:
+	static constexpr size_t granularity = 16;
+	static constexpr size_t max_node_size = 256;
+	static constexpr size_t batch_size = 32;
+
+private:
+	static_assert(sizeof(void*) == 8, "tagged pointers need 64-bit pointers");
+
+	static constexpr size_t no_of_classes = max_node_size / granularity;
+	static constexpr int tag_shift = 48;
+	static constexpr uint64_t pointer_mask = (uint64_t{1} << tag_shift) - 1;
+
+	struct Node
+	{
+		std::atomic<Node*> next_batch; // link of the shared free list - meaningful in the first node of a batch
+		Node* next;                    // link inside a batch or a thread cache
+	};
+	static_assert(sizeof(Node) <= granularity);
+
+	struct alignas(64) SizeClass
+	{
+		std::atomic<uint64_t> head = 0; // tag << 48 | address of the first node of the first batch
+	};
+
+	struct Slab
+	{
+		void* data;
+		size_t size;
+	};
+
+	// the free nodes one thread holds for one pool
+	struct CacheEntry
+	{
+		uint64_t pool_id = 0; // 0 - unused
+		NodePoolResource* pool = nullptr;
+		std::array<Node*, no_of_classes> free{};
+		std::array<size_t, no_of_classes> count{};
+
+		// returns the cached nodes to the pool; registry_mtx_ must be held and the pool alive
+		void give_back()
+		{
+			for (size_t c = 0; c < no_of_classes; ++c)
+				if (free[c])
+					push_batch(pool->classes_[c], free[c]);
+			clear();
+		}
+
+		void clear()
+		{
+			pool_id = 0;
+			pool = nullptr;
+			free.fill(nullptr);
+			count.fill(0);
+		}
+	};
+
+	// one entry per pool a thread uses, up to no_of_entries pools at a time - further pools are served
+	// straight from their shared lists until an entry frees up (its pool is destroyed)
+	struct ThreadCache
+	{
+		static constexpr size_t no_of_entries = 4;
+
+		std::array<CacheEntry, no_of_entries> entries;
+		uint64_t seen_destroyed = 0; // destroyed_pools_ when dead entries were last dropped
+
+		ThreadCache() = default;
+		ThreadCache(const ThreadCache&) = delete;
+		ThreadCache& operator=(const ThreadCache&) = delete;
+
+		// nodes of destroyed pools are gone with their slabs
+		~ThreadCache()
+		{
+			std::lock_guard lk{registry_mtx_};
+			for (auto& entry : entries)
+				if (entry.pool_id != 0 && live_pools_.contains(entry.pool_id))
+					entry.give_back();
+		}
+
+		CacheEntry* attach(NodePoolResource* pool)
+		{
+			if (CacheEntry* entry = unused_entry())
+				return bind(*entry, pool);
+
+			const uint64_t destroyed = destroyed_pools_.load(std::memory_order_acquire);
+			if (destroyed == seen_destroyed)
+				return nullptr;
+
+			{
+				std::lock_guard lk{registry_mtx_};
+				for (auto& entry : entries)
+					if (!live_pools_.contains(entry.pool_id))
+						entry.clear();
+			}
+			seen_destroyed = destroyed;
+
+			CacheEntry* entry = unused_entry();
+			return entry ? bind(*entry, pool) : nullptr;
+		}
+
+	private:
+		CacheEntry* unused_entry()
+		{
+			for (auto& entry : entries)
+				if (entry.pool_id == 0)
+					return &entry;
+			return nullptr;
+		}
+
+		static CacheEntry* bind(CacheEntry& entry, NodePoolResource* pool)
+		{
+			entry.pool_id = pool->id_;
+			entry.pool = pool;
+			return &entry;
+		}
+	};
+
+	inline static std::atomic<uint64_t> next_id_ = 1;
+	inline static std::mutex registry_mtx_;
+	inline static std::unordered_set<uint64_t> live_pools_;
+	inline static std::atomic<uint64_t> destroyed_pools_ = 0;
+
+	const uint64_t id_ = next_id_++;
+	std::pmr::memory_resource* upstream_;
+	const size_t slab_size_;
+	std::array<SizeClass, no_of_classes> classes_;
+
+	std::mutex slabs_mtx_;
+	std::vector<Slab> slabs_;
+
+public:
+	explicit NodePoolResource(size_t slab_size = 64 * 1024, std::pmr::memory_resource* upstream = std::pmr::new_delete_resource())
+		: upstream_{upstream}, slab_size_{std::max(slab_size, batch_size * max_node_size)}
+	{
+		std::lock_guard lk{registry_mtx_};
+		live_pools_.insert(id_);
+	}
+
+	NodePoolResource(const NodePoolResource&) = delete;
+	NodePoolResource& operator=(const NodePoolResource&) = delete;
+
+	~NodePoolResource() override
+	{
+		{
+			std::lock_guard lk{registry_mtx_};
+			live_pools_.erase(id_);
+		}
+		destroyed_pools_.fetch_add(1, std::memory_order_release);
+
+		for (const auto& slab : slabs_)
+			upstream_->deallocate(slab.data, slab.size, alignof(std::max_align_t));
+	}
+
+	size_t slab_count()
+	{
+		std::lock_guard lk{slabs_mtx_};
+		return slabs_.size();
+	}
+
+	std::pmr::memory_resource* upstream_resource() const
+	{
+		return upstream_;
+	}
+
+protected:
+	void* do_allocate(size_t bytes, size_t alignment) override
+	{
+		if (bytes > max_node_size || alignment > granularity)
+			return upstream_->allocate(bytes, alignment);
+
+		const size_t c = class_of(bytes);
+		CacheEntry* cache = cache_of_this_thread();
+		if (!cache)
+			return allocate_shared(c);
+
+		while (!cache->free[c])
+		{
+			if (Node* batch = pop_batch(classes_[c]))
+			{
+				cache->free[c] = batch;
+				for (Node* node = batch; node; node = node->next)
+					++cache->count[c];
+			}
+			else
+				refill(c);
+		}
+
+		Node* node = cache->free[c];
+		cache->free[c] = node->next;
+		--cache->count[c];
+		return node;
+	}
+
+	void do_deallocate(void* p, size_t bytes, size_t alignment) override
+	{
+		if (bytes > max_node_size || alignment > granularity)
+			return upstream_->deallocate(p, bytes, alignment);
+
+		const size_t c = class_of(bytes);
+		Node* node = static_cast<Node*>(p);
+		CacheEntry* cache = cache_of_this_thread();
+		if (!cache)
+		{
+			node->next = nullptr;
+			return push_batch(classes_[c], node);
+		}
+
+		node->next = cache->free[c];
+		cache->free[c] = node;
+
+		// keep batch_size nodes, hand the other batch_size to the shared list
+		if (++cache->count[c] == 2 * batch_size)
+		{
+			Node* last = node;
+			for (size_t i = 1; i < batch_size; ++i)
+				last = last->next;
+			cache->free[c] = last->next;
+			last->next = nullptr;
+			cache->count[c] -= batch_size;
+			push_batch(classes_[c], node);
+		}
+	}
+
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+	{
+		return this == &other;
+	}
+
+private:
+	static size_t class_of(size_t bytes)
+	{
+		return (std::max<size_t>(bytes, 1) + granularity - 1) / granularity - 1;
+	}
+
+	static Node* pointer_of(uint64_t head)
+	{
+		return reinterpret_cast<Node*>(head & pointer_mask);
+	}
+
+	static uint64_t next_head(uint64_t head, Node* node)
+	{
+		const auto address = reinterpret_cast<uint64_t>(node);
+		assert((address & ~pointer_mask) == 0);
+		return ((head >> tag_shift) + 1) << tag_shift | address;
+	}
+
+	static Node* pop_batch(SizeClass& size_class)
+	{
+		uint64_t head = size_class.head.load(std::memory_order_acquire);
+		while (Node* batch = pointer_of(head))
+		{
+			// batch may be popped and reused by another thread meanwhile - next_batch is then stale, but the tag
+			// changed and the CAS fails; slabs are never unmapped, so the read itself is safe
+			Node* next = batch->next_batch.load(std::memory_order_relaxed);
+			if (size_class.head.compare_exchange_weak(head, next_head(head, next), std::memory_order_acquire, std::memory_order_acquire))
+				return batch;
+		}
+		return nullptr;
+	}
+
+	static void push_batch(SizeClass& size_class, Node* batch)
+	{
+		uint64_t head = size_class.head.load(std::memory_order_relaxed);
+		do
+			batch->next_batch.store(pointer_of(head), std::memory_order_relaxed);
+		while (!size_class.head.compare_exchange_weak(head, next_head(head, batch), std::memory_order_release, std::memory_order_relaxed));
+	}
+
+	// nullptr when the thread already caches nodes of no_of_entries other pools
+	CacheEntry* cache_of_this_thread()
+	{
+		thread_local ThreadCache cache;
+		for (auto& entry : cache.entries)
+			if (entry.pool_id == id_)
+				return &entry;
+		return cache.attach(this);
+	}
+
+	// without a thread cache: one node off the first batch, the rest of the batch goes back
+	Node* allocate_shared(size_t c)
+	{
+		while (true)
+		{
+			if (Node* batch = pop_batch(classes_[c]))
+			{
+				if (batch->next)
+					push_batch(classes_[c], batch->next);
+				return batch;
+			}
+			refill(c);
+		}
+	}
+
+	// carves a new slab of class c into batches and pushes them to the shared list
+	void refill(size_t c)
+	{
+		void* data;
+		{
+			std::lock_guard lk{slabs_mtx_};
+			if (pointer_of(classes_[c].head.load(std::memory_order_acquire)) != nullptr)
+				return; // another thread has refilled meanwhile
+
+			data = upstream_->allocate(slab_size_, alignof(std::max_align_t));
+			slabs_.push_back({data, slab_size_});
+		}
+
+		auto* bytes = static_cast<std::byte*>(data);
+		const size_t node_size = (c + 1) * granularity;
+		const size_t no_of_nodes = slab_size_ / node_size;
+
+		for (size_t first = 0; first < no_of_nodes; first += batch_size)
+		{
+			const size_t last = std::min(first + batch_size, no_of_nodes) - 1;
+			for (size_t i = first; i <= last; ++i)
+				new (bytes + i * node_size) Node{nullptr, i < last ? reinterpret_cast<Node*>(bytes + (i + 1) * node_size) : nullptr};
+			push_batch(classes_[c], reinterpret_cast<Node*>(bytes + first * node_size));
+		}
+	}
+};
+
+#endif
@@ -0,0 +1,311 @@
+#ifndef THREAD_ARENA_HPP
+#define THREAD_ARENA_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#include <vector>
+
+// Per-thread bump allocator for per-request lifetimes:
+//
+//   void handle(const Request& request)
+//   {
+//       ThreadArena::Scope scope;                            // everything allocated below is released at }
+//       std::pmr::vector<std::pmr::string> tokens{&ThreadArena::local()};
+//       ...
+//   }
+//
+// ThreadArena::local() is the calling thread's arena (created on first use, destroyed with the thread).
+// Allocation bumps a pointer in 64 KiB chunks, which are kept for reuse - a steady request loop stops calling
+// upstream after the first requests. A Scope remembers the bump position and rewinds to it when it ends; scopes nest.
+// Deallocation is optional: the last block is given back by moving the pointer back, other blocks of up to
+// max_small_size bytes are reused for later allocations of their size class, the rest waits for the scope's end.
+//
+// Any thread may free a block: a block freed on another thread than the one whose arena allocated it is handed back
+// to the owner (pushed onto its lock-free list of returned blocks), which reuses it - the freeing thread never touches
+// the owner's bump state. A block allocated through the arena object of another thread comes from the calling
+// thread's own arena. As with any memory, a block must not be used or freed after the scope that allocated it has
+// ended (or, for blocks allocated outside any scope, after its thread has exited).
+class ThreadArena : public std::pmr::memory_resource
+{
+public:
+	static constexpr size_t chunk_size = 64 * 1024;
+	static constexpr size_t max_small_size = 256;
+	static constexpr size_t max_alignment = 4096;
+
+private:
+	static constexpr size_t granularity = 16;
+	static constexpr size_t no_of_classes = max_small_size / granularity;
+
+	// at the start of every chunk - chunks are aligned to chunk_size, so a block finds its chunk by masking its address
+	struct alignas(64) ChunkHeader
+	{
+		ThreadArena* owner;
+		size_t size;
+		bool large;      // holds a single block bigger than a chunk
+		uint64_t serial; // large chunks: order of allocation - large_ is sorted by it
+	};
+
+	struct FreeBlock
+	{
+		FreeBlock* next;
+		size_t size;
+	};
+
+	struct Mark
+	{
+		size_t next_chunk;
+		std::byte* pos;
+		std::byte* end;
+		uint64_t next_large_serial; // large chunks from this serial on belong to the scope
+	};
+
+	inline static thread_local ThreadArena* this_thread_arena_ = nullptr;
+
+	std::pmr::memory_resource* upstream_ = std::pmr::new_delete_resource();
+	std::vector<ChunkHeader*> chunks_; // chunks_[next_chunk_ - 1] is being bumped, the ones after it are spare
+	size_t next_chunk_ = 0;
+	std::byte* pos_ = nullptr;
+	std::byte* end_ = nullptr;
+	std::vector<ChunkHeader*> large_;
+	uint64_t next_large_serial_ = 0;
+	std::array<FreeBlock*, no_of_classes> free_{};
+
+	alignas(64) std::atomic<FreeBlock*> returned_ = nullptr; // blocks freed on other threads
+
+	ThreadArena()
+	{
+		this_thread_arena_ = this;
+	}
+
+public:
+	// rewinds the calling thread's arena to where it was when the scope was created
+	class Scope
+	{
+		ThreadArena& arena_;
+		Mark mark_;
+
+	public:
+		Scope() : arena_{ThreadArena::local()}, mark_{arena_.mark()} {}
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+
+		~Scope()
+		{
+			arena_.rewind(mark_);
+		}
+	};
+
+	static ThreadArena& local()
+	{
+		thread_local ThreadArena arena;
+		return arena;
+	}
+
+	// the arena whose chunk holds p (a block allocated by some ThreadArena)
+	static ThreadArena* owner_of(const void* p)
+	{
+		return chunk_of(p)->owner;
+	}
+
+	ThreadArena(const ThreadArena&) = delete;
+	ThreadArena& operator=(const ThreadArena&) = delete;
+
+	~ThreadArena() override
+	{
+		for (ChunkHeader* chunk : chunks_)
+			upstream_->deallocate(chunk, chunk->size, chunk_size);
+		for (ChunkHeader* chunk : large_)
+			upstream_->deallocate(chunk, chunk->size, chunk_size);
+		this_thread_arena_ = nullptr;
+	}
+
+	// bytes obtained from upstream
+	size_t capacity() const
+	{
+		size_t total = 0;
+		for (const ChunkHeader* chunk : chunks_)
+			total += chunk->size;
+		for (const ChunkHeader* chunk : large_)
+			total += chunk->size;
+		return total;
+	}
+
+protected:
+	void* do_allocate(size_t bytes, size_t alignment) override
+	{
+		if (this_thread_arena_ != this)
+			return local().allocate(bytes, alignment);
+
+		if (alignment > max_alignment)
+			throw std::bad_alloc{};
+
+		const size_t size = size_of(bytes);
+		alignment = std::max(alignment, granularity);
+
+		if (size <= max_small_size && alignment == granularity)
+			if (FreeBlock* block = free_[class_of(size)])
+			{
+				free_[class_of(size)] = block->next;
+				return block;
+			}
+
+		if (void* p = bump(size, alignment))
+			return p;
+
+		return allocate_slow(size, alignment);
+	}
+
+	void do_deallocate(void* p, size_t bytes, size_t) override
+	{
+		ThreadArena* owner = owner_of(p);
+		if (owner == this_thread_arena_)
+			owner->free_local(p, size_of(bytes));
+		else
+			owner->hand_back(p, size_of(bytes));
+	}
+
+	// all thread arenas are interchangeable - a block goes back to its owner whichever arena frees it
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+	{
+		return dynamic_cast<const ThreadArena*>(&other) != nullptr;
+	}
+
+private:
+	static size_t size_of(size_t bytes)
+	{
+		return (std::max<size_t>(bytes, 1) + granularity - 1) / granularity * granularity;
+	}
+
+	static size_t class_of(size_t size)
+	{
+		return size / granularity - 1;
+	}
+
+	static ChunkHeader* chunk_of(const void* p)
+	{
+		return reinterpret_cast<ChunkHeader*>(reinterpret_cast<uintptr_t>(p) & ~(uintptr_t{chunk_size} - 1));
+	}
+
+	void* bump(size_t size, size_t alignment)
+	{
+		const auto address = reinterpret_cast<uintptr_t>(pos_);
+		const uintptr_t aligned = (address + alignment - 1) & ~(uintptr_t{alignment} - 1);
+		if (pos_ == nullptr || aligned + size > reinterpret_cast<uintptr_t>(end_))
+			return nullptr;
+
+		pos_ = reinterpret_cast<std::byte*>(aligned + size);
+		return reinterpret_cast<void*>(aligned);
+	}
+
+	void* allocate_slow(size_t size, size_t alignment)
+	{
+		if (drain_returned() && size <= max_small_size && alignment == granularity)
+			if (FreeBlock* block = free_[class_of(size)])
+			{
+				free_[class_of(size)] = block->next;
+				return block;
+			}
+
+		if (sizeof(ChunkHeader) + alignment + size > chunk_size)
+			return allocate_large(size, alignment);
+
+		if (next_chunk_ == chunks_.size())
+			chunks_.push_back(new_chunk(chunk_size, false));
+
+		ChunkHeader* chunk = chunks_[next_chunk_++];
+		pos_ = reinterpret_cast<std::byte*>(chunk) + sizeof(ChunkHeader);
+		end_ = reinterpret_cast<std::byte*>(chunk) + chunk_size;
+
+		return bump(size, alignment);
+	}
+
+	void* allocate_large(size_t size, size_t alignment)
+	{
+		const size_t offset = std::max(sizeof(ChunkHeader), alignment);
+		const size_t chunk_bytes = (offset + size + chunk_size - 1) / chunk_size * chunk_size;
+
+		ChunkHeader* chunk = new_chunk(chunk_bytes, true);
+		chunk->serial = next_large_serial_++;
+		large_.push_back(chunk);
+		return reinterpret_cast<std::byte*>(chunk) + offset;
+	}
+
+	ChunkHeader* new_chunk(size_t size, bool large)
+	{
+		return new (upstream_->allocate(size, chunk_size)) ChunkHeader{this, size, large, 0};
+	}
+
+	void release_large(ChunkHeader* chunk)
+	{
+		const auto it = std::find(large_.rbegin(), large_.rend(), chunk);
+		if (it != large_.rend())
+		{
+			large_.erase(std::next(it).base());
+			upstream_->deallocate(chunk, chunk->size, chunk_size);
+		}
+	}
+
+	// owner thread only
+	void free_local(void* p, size_t size)
+	{
+		ChunkHeader* chunk = chunk_of(p);
+		if (chunk->large)
+			release_large(chunk);
+		else if (static_cast<std::byte*>(p) + size == pos_)
+			pos_ = static_cast<std::byte*>(p);
+		else if (size <= max_small_size)
+			free_[class_of(size)] = new (p) FreeBlock{free_[class_of(size)], size};
+	}
+
+	// any thread
+	void hand_back(void* p, size_t size)
+	{
+		auto* block = new (p) FreeBlock{returned_.load(std::memory_order_relaxed), size};
+		while (!returned_.compare_exchange_weak(block->next, block, std::memory_order_release, std::memory_order_relaxed))
+			;
+	}
+
+	// takes the blocks returned by other threads; true if there were any
+	bool drain_returned()
+	{
+		FreeBlock* block = returned_.exchange(nullptr, std::memory_order_acquire);
+		const bool any = block != nullptr;
+		while (block)
+		{
+			FreeBlock* next = block->next;
+			free_local(block, block->size);
+			block = next;
+		}
+		return any;
+	}
+
+	Mark mark() const
+	{
+		return {next_chunk_, pos_, end_, next_large_serial_};
+	}
+
+	void rewind(const Mark& mark)
+	{
+		drain_returned();
+		free_.fill(nullptr); // may hold blocks allocated after the mark
+
+		// by serial, not by count - large blocks from before the mark may have been released in between
+		while (!large_.empty() && large_.back()->serial >= mark.next_large_serial)
+		{
+			upstream_->deallocate(large_.back(), large_.back()->size, chunk_size);
+			large_.pop_back();
+		}
+
+		next_chunk_ = mark.next_chunk;
+		pos_ = mark.pos;
+		end_ = mark.end;
+	}
+};
+
+#endif
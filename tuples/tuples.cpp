@@ -1,5 +1,6 @@
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/matchers/catch_matchers_floating_point.hpp>
+#include <iomanip>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -12,6 +13,15 @@
 #include <map>
 #include <memory_resource>
 #include <list>
+#include <atomic>
+#include <thread>
+#include <cstdlib>
+
+#include "allocator_bench.hpp"
+#include "arena.hpp"
+#include "bench.hpp"
+#include "node_pool.hpp"
+#include "thread_arena.hpp"
 
 using namespace std;
 
@@ -291,20 +301,8 @@ TEST_CASE("Data & tuple_for_each")
 	tuple_for_each(d1.tied(), print);
 }
 
-template<typename Func>
-auto benchmark(Func test_func, int iterations)
-{
-	const auto start = std::chrono::system_clock::now();
-	while (iterations-- > 0)
-		test_func();
-	const auto stop = std::chrono::system_clock::now();
-	const auto secs = std::chrono::duration<double>(stop - start);
-	return secs.count();
-}
-
 TEST_CASE("benchmark")
 {
-	constexpr int iterations{100};
 	constexpr int total_nodes{20'000};
 
 	auto default_std_alloc = [total_nodes]
@@ -312,6 +310,7 @@ TEST_CASE("benchmark")
 			std::list<int> list;
 			for (int i{}; i != total_nodes; ++i)
 				list.push_back(i);
+			bench::do_not_optimize(list);
 		};
 
 	auto default_pmr_alloc = [total_nodes]
@@ -319,6 +318,7 @@ TEST_CASE("benchmark")
 			std::pmr::list<int> list;
 			for (int i{}; i != total_nodes; ++i)
 				list.push_back(i);
+			bench::do_not_optimize(list);
 		};
 
 	auto pmr_alloc_no_buf = [total_nodes]
@@ -328,6 +328,7 @@ TEST_CASE("benchmark")
 			std::pmr::list<int> list{pa};
 			for (int i{}; i != total_nodes; ++i)
 				list.push_back(i);
+			bench::do_not_optimize(list);
 		};
 
 	auto pmr_alloc_and_buf = [total_nodes]
@@ -338,16 +339,269 @@ TEST_CASE("benchmark")
 			std::pmr::list<int> list{pa};
 			for (int i{}; i != total_nodes; ++i)
 				list.push_back(i);
+			bench::do_not_optimize(list);
 		};
 
-	const double t1 = benchmark(default_std_alloc, iterations);
-	const double t2 = benchmark(default_pmr_alloc, iterations);
-	const double t3 = benchmark(pmr_alloc_no_buf, iterations);
-	const double t4 = benchmark(pmr_alloc_and_buf, iterations);
-
-	std::cout << std::fixed << std::setprecision(3)
-		<< "t1 (default std alloc): " << t1 << " sec; t1/t1: " << t1 / t1 << '\n'
-		<< "t2 (default pmr alloc): " << t2 << " sec; t1/t2: " << t1 / t2 << '\n'
-		<< "t3 (pmr alloc  no buf): " << t3 << " sec; t1/t3: " << t1 / t3 << '\n'
-		<< "t4 (pmr alloc and buf): " << t4 << " sec; t1/t4: " << t1 / t4 << '\n';
-}
\ No newline at end of file
+	NodePoolResource node_pool; // shared by all runs - nodes freed by one run are reused by the next
+	auto pmr_node_pool = [total_nodes, &node_pool]
+		{
+			std::pmr::list<int> list{&node_pool};
+			for (int i{}; i != total_nodes; ++i)
+				list.push_back(i);
+			bench::do_not_optimize(list);
+		};
+
+	const bench::Result r1 = bench::run("default std alloc", default_std_alloc);
+	const bench::Result r2 = bench::run("default pmr alloc", default_pmr_alloc);
+	const bench::Result r3 = bench::run("pmr alloc  no buf", pmr_alloc_no_buf);
+	const bench::Result r4 = bench::run("pmr alloc and buf", pmr_alloc_and_buf);
+	const bench::Result r5 = bench::run("pmr node pool    ", pmr_node_pool);
+
+	for (const auto& r : {r1, r2, r3, r4, r5})
+		std::cout << r << "; speedup vs std alloc: " << std::fixed << std::setprecision(3) << r1.median / r.median << '\n';
+}
+
+TEST_CASE("ArenaResource")
+{
+	alloc_bench::CountingResource upstream;
+	ArenaResource arena{1024, &upstream};
+
+	auto* p1 = arena.allocate(100, 1);
+	auto* p2 = arena.allocate(8, 64);
+	CHECK(reinterpret_cast<uintptr_t>(p2) % 64 == 0);
+	CHECK(static_cast<std::byte*>(p2) >= static_cast<std::byte*>(p1) + 100);
+
+	SECTION("grows by chunks from upstream")
+	{
+		for (int i = 0; i < 100; ++i)
+			(void)arena.allocate(100, 8);
+		CHECK(upstream.allocations() > 1);
+
+		SECTION("reset coalesces the chunks into one")
+		{
+			const size_t capacity = arena.capacity();
+			arena.reset();
+			CHECK(arena.capacity() == capacity);
+
+			const size_t allocations = upstream.allocations();
+			for (int i = 0; i < 100; ++i)
+				(void)arena.allocate(100, 8);
+			CHECK(upstream.allocations() == allocations); // fits into the coalesced chunk
+			CHECK(arena.allocate(1, 1) != nullptr);
+		}
+	}
+
+	SECTION("reset reuses the memory")
+	{
+		arena.reset();
+		CHECK(arena.allocate(100, 1) == p1);
+	}
+}
+
+TEST_CASE("NodePoolResource")
+{
+	NodePoolResource pool{4096};
+
+	SECTION("size classes of 16 bytes")
+	{
+		void* p1 = pool.allocate(24);
+		void* p2 = pool.allocate(24);
+		CHECK(reinterpret_cast<uintptr_t>(p1) % 16 == 0);
+		CHECK(std::abs(static_cast<std::byte*>(p2) - static_cast<std::byte*>(p1)) == 32);
+
+		pool.deallocate(p2, 24);
+		CHECK(pool.allocate(32) == p2); // same class, last freed first
+		CHECK(pool.slab_count() == 1);
+	}
+
+	SECTION("pools interleaved on one thread")
+	{
+		constexpr size_t no_of_pools = 6; // more than a thread caches at once
+		std::vector<std::unique_ptr<NodePoolResource>> pools;
+		pools.push_back(nullptr);
+		for (size_t i = 1; i < no_of_pools; ++i)
+			pools.push_back(std::make_unique<NodePoolResource>(4096));
+
+		std::vector<std::vector<size_t*>> nodes(no_of_pools);
+		size_t corrupted = 0;
+		for (int round = 0; round < 3; ++round)
+		{
+			for (size_t i = 0; i < 1000; ++i)
+				for (size_t p = 0; p < no_of_pools; ++p)
+				{
+					auto& mr = p == 0 ? pool : *pools[p];
+					nodes[p].push_back(static_cast<size_t*>(mr.allocate(2 * sizeof(size_t))));
+					nodes[p].back()[0] = p;
+					nodes[p].back()[1] = i;
+				}
+
+			for (size_t p = 0; p < no_of_pools; ++p)
+			{
+				auto& mr = p == 0 ? pool : *pools[p];
+				for (size_t i = 0; i < nodes[p].size(); ++i)
+					if (nodes[p][i][0] != p || nodes[p][i][1] != i)
+						++corrupted;
+				for (auto* node : nodes[p])
+					mr.deallocate(node, 2 * sizeof(size_t));
+				nodes[p].clear();
+			}
+		}
+
+		CHECK(corrupted == 0);
+		for (size_t p = 1; p < no_of_pools; ++p)
+			CHECK(pools[p]->slab_count() <= 2); // freed nodes are reused, cached or not
+		CHECK(pool.slab_count() <= 2);
+
+		pools.clear(); // destroyed pools give their cache entries up
+		std::unique_ptr<NodePoolResource> next = std::make_unique<NodePoolResource>(4096);
+		void* p = next->allocate(16);
+		next->deallocate(p, 16);
+		CHECK(next->allocate(16) == p);
+	}
+
+	SECTION("large blocks come from upstream")
+	{
+		void* p = pool.allocate(1000);
+		pool.deallocate(p, 1000);
+		CHECK(pool.slab_count() == 0);
+	}
+
+	SECTION("shared by threads")
+	{
+		constexpr size_t no_of_threads = 4;
+		constexpr size_t no_of_nodes = 2000;
+		std::atomic<size_t> corrupted = 0;
+
+		std::vector<std::thread> thds;
+		for (size_t t = 0; t < no_of_threads; ++t)
+			thds.emplace_back([&, t] {
+				std::vector<size_t*> nodes;
+				for (int round = 0; round < 50; ++round)
+				{
+					for (size_t i = 0; i < no_of_nodes; ++i)
+					{
+						nodes.push_back(static_cast<size_t*>(pool.allocate(2 * sizeof(size_t))));
+						nodes.back()[0] = t;
+						nodes.back()[1] = i;
+					}
+					for (size_t i = 0; i < no_of_nodes; ++i)
+						if (nodes[i][0] != t || nodes[i][1] != i) // a node handed out twice
+							++corrupted;
+					for (auto* node : nodes)
+						pool.deallocate(node, 2 * sizeof(size_t));
+					nodes.clear();
+				}
+			});
+
+		for (auto& thd : thds)
+			thd.join();
+
+		CHECK(corrupted == 0);
+		CHECK(pool.slab_count() <= no_of_threads * no_of_nodes * 16 / 4096 + no_of_threads);
+	}
+}
+
+TEST_CASE("node pool scaling")
+{
+	alloc_bench::run_scaling(std::cout, std::max(4u, std::thread::hardware_concurrency()));
+}
+
+TEST_CASE("allocator benchmark suite")
+{
+	const size_t no_of_threads = std::max(2u, std::thread::hardware_concurrency());
+	const auto results = alloc_bench::run_suite(std::cout, no_of_threads);
+
+	CHECK(results.size() == alloc_bench::workloads().size() * alloc_bench::configs().size() * 2);
+}
+
+TEST_CASE("ThreadArena")
+{
+	ThreadArena& arena = ThreadArena::local();
+
+	SECTION("scope rewinds")
+	{
+		void* p1;
+		{
+			ThreadArena::Scope scope;
+			p1 = arena.allocate(100);
+		}
+		ThreadArena::Scope scope;
+		CHECK(arena.allocate(100) == p1);
+	}
+
+	SECTION("freed blocks are reused")
+	{
+		ThreadArena::Scope scope;
+		void* a = arena.allocate(32);
+		void* b = arena.allocate(32);
+		CHECK(reinterpret_cast<uintptr_t>(a) % 16 == 0);
+
+		arena.deallocate(b, 32); // last block - the bump pointer moves back
+		CHECK(arena.allocate(32) == b);
+
+		arena.deallocate(a, 32); // size class free list
+		CHECK(arena.allocate(24) == a);
+	}
+
+	SECTION("large blocks")
+	{
+		ThreadArena::Scope scope;
+		const size_t capacity = arena.capacity();
+		auto* p = static_cast<char*>(arena.allocate(3 * ThreadArena::chunk_size, 64));
+		p[3 * ThreadArena::chunk_size - 1] = 'x';
+		CHECK(reinterpret_cast<uintptr_t>(p) % 64 == 0);
+		CHECK(ThreadArena::owner_of(p) == &arena);
+
+		arena.deallocate(p, 3 * ThreadArena::chunk_size, 64);
+		CHECK(arena.capacity() == capacity);
+	}
+
+	SECTION("a scope releases its large blocks after an older one was freed")
+	{
+		const size_t capacity = arena.capacity();
+		void* outer = arena.allocate(2 * ThreadArena::chunk_size);
+		{
+			ThreadArena::Scope scope;
+			(void)arena.allocate(2 * ThreadArena::chunk_size);
+			arena.deallocate(outer, 2 * ThreadArena::chunk_size); // leaves large_ shorter than at the mark
+		}
+		CHECK(arena.capacity() == capacity);
+	}
+
+	SECTION("a block freed on another thread goes back to its owner")
+	{
+		ThreadArena::Scope scope;
+		void* p = arena.allocate(48);
+		std::thread{[&] { arena.deallocate(p, 48); }}.join();
+
+		for (size_t i = 0; i < ThreadArena::chunk_size / 1024; ++i) // fill the chunk - the next one takes the returned blocks
+			(void)arena.allocate(1024);
+		CHECK(arena.allocate(48) == p);
+	}
+
+	SECTION("allocating through the arena of another thread uses the own one")
+	{
+		std::thread{[&] {
+			void* p = arena.allocate(16);
+			CHECK(ThreadArena::owner_of(p) == &ThreadArena::local());
+			CHECK(ThreadArena::owner_of(p) != &arena);
+			arena.deallocate(p, 16);
+		}}.join();
+	}
+
+	SECTION("containers")
+	{
+		ThreadArena::Scope scope;
+		std::pmr::vector<std::pmr::string> words{&arena};
+		for (int i = 0; i < 1000; ++i)
+			words.emplace_back(40, 'a' + i % 26);
+
+		std::thread{[&] { words = std::pmr::vector<std::pmr::string>{&ThreadArena::local()}; }}.join();
+		CHECK(words.empty());
+	}
+}
+
+TEST_CASE("request loop")
+{
+	alloc_bench::run_request_loop(std::cout, std::max(2u, std::thread::hardware_concurrency()));
+}